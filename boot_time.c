@@ -0,0 +1,25 @@
+// Storage for the boot timeline (boot_time.h) and the USB state check.
+//
+// USB enumeration runs from the USB interrupt while the main loop is
+// already scanning, so "configured" is polled from housekeeping; the
+// ChibiOS driver state goes to USB_ACTIVE once the host has set a
+// configuration.
+
+#include "quantum.h"
+#include "usb_main.h"
+#include "boot_time.h"
+
+uint8_t  boot_time_reached = 0;
+uint32_t boot_time_at[BOOT_PHASES];
+
+bool boot_time_task(void) {
+    if (boot_time_reached & (1u << BOOT_USB_CONFIGURED)) {
+        return false;
+    }
+    boot_time_mark(BOOT_MAIN_LOOP);
+    if (USB_DRIVER.state != USB_ACTIVE) {
+        return false;
+    }
+    boot_time_mark(BOOT_USB_CONFIGURED);
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "trace.h"
+
+// Boot timeline: when each boot phase was first reached, in us on the
+// RP2040 timer (TRACE_NOW), which starts counting in early startup before
+// the double-tap reset window. Read from the host with
+// HOST_CMD_BOOT_TIMELINE, tools/trace_decode.py --boot.
+
+enum boot_phase {
+    BOOT_KEYBOARD_INIT,  // keyboard_pre_init_kb(): QMK's keyboard_init() starts
+    BOOT_POST_INIT,      // keyboard_post_init_kb() entry
+    BOOT_MAIN_LOOP,      // first housekeeping_task_kb(): the matrix is scanned
+    BOOT_USB_CONFIGURED, // host set a configuration: reports can go out
+    BOOT_USER_INIT,      // keyboard_post_init_user() done: settings, RGB
+    BOOT_FIRST_KEY,      // first key event processed
+    BOOT_PHASES,
+};
+
+_Static_assert(BOOT_PHASES <= 8, "reached phases are a byte mask");
+
+extern uint8_t  boot_time_reached;
+extern uint32_t boot_time_at[BOOT_PHASES];
+
+// Keeps the first time only, so it can sit on paths that run every event.
+static inline void boot_time_mark(uint8_t phase) {
+    if (!(boot_time_reached & (1u << phase))) {
+        boot_time_reached |= 1u << phase;
+        boot_time_at[phase] = TRACE_NOW();
+    }
+}
+
+// From housekeeping_task_kb(). Returns true once, in the loop that first
+// sees USB configured.
+bool boot_time_task(void);
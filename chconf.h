@@ -0,0 +1,8 @@
+#pragma once
+
+// Sleep in the idle thread, so waits in power.c stop the core (WFI)
+#ifdef POWER_SAVE_ENABLE
+#    define CORTEX_ENABLE_WFI_IDLE TRUE
+#endif
+
+#include_next <chconf.h>
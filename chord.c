@@ -0,0 +1,194 @@
+// Chord engine. QMK's combo code walks every combo and its key list on each
+// key event and holds keys back for COMBO_TERM. Here the keys waiting for a
+// chord are a bit mask and one binary search in a table of every chord and
+// every part of a chord tells whether they can still become one, are one,
+// or are done:
+//   - the mask is no part of any chord: the waiting keys are settled (a
+//     chord if they are one, their own presses otherwise), so keys in no
+//     chord are never held back;
+//   - the mask is a chord and no longer chord contains it: it fires now;
+//   - otherwise the key waits for the next press, a release or
+//     CHORD_TERM_MS.
+// A chord's keycode is held until the first of its keys is released; the
+// releases of its keys never reach QMK.
+
+#include <string.h>
+#include "quantum.h"
+#include "chord.h"
+#include "hot_path.h"
+
+_Static_assert(MATRIX_ROWS * MATRIX_COLS <= 32, "chord masks hold one bit per matrix position");
+
+static const chord_t chords[] = {
+#define CHORD(keycode, keys) {keycode, keys},
+#include "chords.def"
+#undef CHORD
+};
+
+#define CHORD(keycode, keys) _Static_assert(__builtin_popcount(keys) <= CHORD_MAX_KEYS, "chord has more than CHORD_MAX_KEYS keys");
+#include "chords.def"
+#undef CHORD
+
+static chord_entry_t entries[0
+#define CHORD(keycode, keys) +((1u << __builtin_popcount(keys)) - 1)
+#include "chords.def"
+#undef CHORD
+];
+static chord_table_t table;
+
+static keyrecord_t waiting[CHORD_MAX_KEYS];
+static uint8_t     waiting_count = 0;
+static uint32_t    pending       = 0;
+static uint16_t    pending_tmr   = 0;
+static uint32_t    swallowed     = 0;
+static uint32_t    active_keys   = 0;
+static uint16_t    active_keycode;
+
+static uint16_t lower_bound(const chord_table_t *t, uint32_t keys) {
+    uint16_t lo = 0;
+    uint16_t hi = t->count;
+
+    while (lo < hi) {
+        uint16_t mid = (lo + hi) / 2;
+        if (t->entries[mid].keys < keys) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static chord_entry_t *insert(chord_table_t *t, uint32_t keys) {
+    uint16_t pos = lower_bound(t, keys);
+
+    if (pos == t->count || t->entries[pos].keys != keys) {
+        memmove(&t->entries[pos + 1], &t->entries[pos], (t->count - pos) * sizeof(chord_entry_t));
+        t->entries[pos] = (chord_entry_t){.keys = keys};
+        t->count++;
+    }
+    return &t->entries[pos];
+}
+
+void chord_table_build(chord_table_t *t, chord_entry_t *storage, const chord_t *list, uint16_t count) {
+    t->entries = storage;
+    t->count   = 0;
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint32_t keys = list[i].keys;
+        for (uint32_t part = keys; part; part = (part - 1) & keys) {
+            chord_entry_t *entry = insert(t, part);
+            if (part != keys) {
+                entry->extends = true;
+            } else if (!entry->chord) {
+                entry->chord = i + 1;
+            }
+        }
+    }
+}
+
+const chord_entry_t *HOT_PATH(chord_table_find)(const chord_table_t *t, uint32_t keys) {
+    uint16_t pos = lower_bound(t, keys);
+
+    if (pos < t->count && t->entries[pos].keys == keys) {
+        return &t->entries[pos];
+    }
+    return NULL;
+}
+
+void chord_init(void) {
+    chord_table_build(&table, entries, chords, ARRAY_SIZE(chords));
+}
+
+static void fire(const chord_entry_t *entry) {
+    if (active_keys) {
+        unregister_code16(active_keycode);
+    }
+    active_keys    = pending;
+    active_keycode = chords[entry->chord - 1].keycode;
+    swallowed |= pending;
+    pending       = 0;
+    waiting_count = 0;
+    register_code16(active_keycode);
+}
+
+static void replay(keyrecord_t *record) {
+#ifndef NO_ACTION_TAPPING
+    action_tapping_process(*record);
+#else
+    process_record(record);
+#endif
+}
+
+// The waiting keys are a chord or were never going to be one.
+static void settle(void) {
+    const chord_entry_t *entry = chord_table_find(&table, pending);
+
+    if (entry && entry->chord) {
+        fire(entry);
+        return;
+    }
+
+    uint8_t count = waiting_count;
+    pending       = 0;
+    waiting_count = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        replay(&waiting[i]);
+    }
+}
+
+static bool press(uint32_t bit, keyrecord_t *record) {
+    const chord_entry_t *entry = chord_table_find(&table, pending | bit);
+
+    if (!entry && pending) {
+        settle();
+        entry = chord_table_find(&table, bit);
+    }
+    if (!entry) {
+        return true;
+    }
+
+    if (!pending) {
+        pending_tmr = timer_read();
+    }
+    waiting[waiting_count++] = *record;
+    pending |= bit;
+    if (entry->chord && !entry->extends) {
+        fire(entry);
+    }
+    return false;
+}
+
+static bool release(uint32_t bit) {
+    if (pending & bit) {
+        settle();
+    }
+    if (!(swallowed & bit)) {
+        return true;
+    }
+
+    swallowed &= ~bit;
+    if (active_keys & bit) {
+        unregister_code16(active_keycode);
+        active_keys = 0;
+    }
+    return false;
+}
+
+bool HOT_PATH(chord_process)(keyrecord_t *record) {
+    keypos_t key = record->event.key;
+
+    if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return true;
+    }
+    if (record->event.pressed) {
+        return press(CHORD_KEY(key.row, key.col), record);
+    }
+    return release(CHORD_KEY(key.row, key.col));
+}
+
+void chord_task(void) {
+    if (pending && timer_elapsed(pending_tmr) >= CHORD_TERM_MS) {
+        settle();
+    }
+}
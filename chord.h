@@ -0,0 +1,58 @@
+#pragma once
+
+#include "quantum.h"
+
+// Chords over the switch matrix: the pressed keys are one bit each in a
+// 32-bit mask and chords are found by looking that mask up in a sorted table
+// of every chord and every part of one. See chords.def.
+
+#define CHORD_KEY(row, col) ((uint32_t)1 << ((row) * MATRIX_COLS + (col)))
+
+// How long the first key of a possible chord waits for the rest before it
+// counts as a normal press. Only a key held alone waits that long; any
+// other press or a release decides sooner.
+#ifndef CHORD_TERM_MS
+#    define CHORD_TERM_MS 50
+#endif
+
+// Most keys in one chord.
+#ifndef CHORD_MAX_KEYS
+#    define CHORD_MAX_KEYS 4
+#endif
+
+typedef struct {
+    uint16_t keycode;
+    uint32_t keys;
+} chord_t;
+
+// A chord or part of one. chord is the index + 1 of the chord with exactly
+// these keys, 0 if none; extends is set if some chord has more keys.
+typedef struct {
+    uint32_t keys;
+    uint16_t chord;
+    bool     extends;
+} chord_entry_t;
+
+typedef struct {
+    chord_entry_t *entries;
+    uint16_t       count;
+} chord_table_t;
+
+// Fills entries (room for 2^n - 1 per chord of n keys) with every non-empty
+// subset of every chord, sorted by keys. The first of two identical chords
+// wins.
+void chord_table_build(chord_table_t *table, chord_entry_t *entries, const chord_t *chords, uint16_t count);
+
+// Binary search; NULL if keys is no chord and no part of one.
+const chord_entry_t *chord_table_find(const chord_table_t *table, uint32_t keys);
+
+// Builds the table for chords.def.
+void chord_init(void);
+
+// From pre_process_record_kb(). Holds back presses that may start a chord
+// and returns false for them; they are passed on later if no chord comes of
+// it. Keys in no chord go through untouched.
+bool chord_process(keyrecord_t *record);
+
+// Passes on keys that waited CHORD_TERM_MS.
+void chord_task(void);
@@ -2,11 +2,18 @@
 
 // Encoder Button (active-low gegen GND, mit Pullup)
 #define ENCODER_BTN_PIN GP12
+// ...liegt als virtuelle Taste in der Matrix (matrix.c)
+#define ENCODER_BTN_ROW 6
+#define ENCODER_BTN_COL 0
 #define DYNAMIC_KEYMAP_LAYER_COUNT 5
+// 5 Ebenen: ein 8-bit Layer-State reicht, QMK prueft pro Taste dann 8 statt 32 Ebenen
+#define LAYER_STATE_8BIT
+
+// Entprellzeit (ms); mit debounce_eager.c nur fuer das Loslassen
+#define DEBOUNCE 5
 
 // WS2812 / RGBLIGHT (QMK aktuell)
 #define RGBLIGHT_LIMIT_VAL 80
-#define RGBLIGHT_LAYERS
 #define RGBLIGHT_DEFAULT_MODE RGBLIGHT_MODE_STATIC_LIGHT
 #define RGBLIGHT_DEFAULT_HUE 149
 #define RGBLIGHT_DEFAULT_SAT 255
@@ -15,9 +22,13 @@
 #  define RGBLIGHT_EFFECT_BREATHING
 #endif
 
-// RP2040: double-tap reset into UF2 bootloader
-#define RP2040_BOOTLOADER_DOUBLE_TAP_RESET
-#define RP2040_BOOTLOADER_DOUBLE_TAP_RESET_TIMEOUT 200
+// RP2040: double-tap reset into UF2 bootloader. Every boot waits out the
+// window, so FAST_BOOT_ENABLE drops it: hold the top-left key (bootmagic,
+// matrix 0,0) while plugging in instead.
+#ifndef FAST_BOOT_ENABLE
+#  define RP2040_BOOTLOADER_DOUBLE_TAP_RESET
+#  define RP2040_BOOTLOADER_DOUBLE_TAP_RESET_TIMEOUT 200
+#endif
 
 // optional, aber oft sinnvoll:
 #define RGBLIGHT_SLEEP
@@ -0,0 +1,91 @@
+// Per-key asymmetric debounce: presses are reported on the first scan that
+// sees them, releases only once the key has read open for DEBOUNCE ms.
+//
+// Every key has an 8-bit counter holding the ms left until its release is
+// accepted. A row's counters sit side by side in one 32-bit word, so ageing,
+// reloading and expiry checks are a handful of word operations per row no
+// matter how many of its keys are moving:
+//   - every key that reads closed reloads its counter to DEBOUNCE,
+//   - all counters age by the time since the last call (saturating at 0),
+//   - a key that is down in cooked and whose counter ran out is released.
+// Contact chatter after a press or during a release keeps reloading the
+// counter, so it never produces a second press.
+
+#include "quantum.h"
+#include "debounce.h"
+#include "trace.h"
+#include "hot_path.h"
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+_Static_assert(MATRIX_COLS <= 4, "one 8-bit counter lane per column in a 32-bit word");
+_Static_assert(DEBOUNCE > 0 && DEBOUNCE < 128, "counters use the lane's top bit as guard");
+
+#define LANES_LOW 0x01010101u
+#define LANES_HIGH 0x80808080u
+
+static uint32_t     counters[MATRIX_ROWS];
+static fast_timer_t last_time;
+static bool         counting = false;
+
+// Column bit c -> bit 0 of lane c.
+static inline uint32_t lanes_from_bits(matrix_row_t bits) {
+    return ((uint32_t)bits * 0x00204081u) & LANES_LOW;
+}
+
+// Top bit of lane c -> column bit c.
+static inline matrix_row_t bits_from_lanes(uint32_t high) {
+    return (matrix_row_t)((((high >> 7) * 0x01020408u) >> 24) & 0x0F);
+}
+
+// Per-lane max(lane - amount, 0); lanes and amount are below 128.
+static inline uint32_t lanes_sub(uint32_t lanes, uint8_t amount) {
+    uint32_t diff = (lanes | LANES_HIGH) - amount * LANES_LOW;
+    uint32_t keep = diff & LANES_HIGH;
+    return diff & (keep - (keep >> 7));
+}
+
+// Top bit set in every lane that is not zero.
+static inline uint32_t lanes_nonzero(uint32_t lanes) {
+    return (lanes + (LANES_HIGH - LANES_LOW)) & LANES_HIGH;
+}
+
+void debounce_init(uint8_t num_rows) {
+    (void)num_rows;
+    last_time = timer_read_fast();
+}
+
+bool HOT_PATH(debounce)(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    uint32_t elapsed = timer_elapsed_fast(last_time);
+    bool     cooked_changed = false;
+
+    if (elapsed) {
+        last_time += elapsed;
+    }
+    if (!changed && !counting) {
+        return false;
+    }
+
+    uint8_t age = MIN(elapsed, 127);
+    counting    = false;
+    for (uint8_t row = 0; row < num_rows; row++) {
+        uint32_t reload = lanes_from_bits(raw[row]) * 0xFF;
+        uint32_t lanes  = (lanes_sub(counters[row], age) & ~reload) | (reload & (DEBOUNCE * LANES_LOW));
+
+        matrix_row_t live = bits_from_lanes(lanes_nonzero(lanes));
+        matrix_row_t next = (cooked[row] | raw[row]) & live;
+
+        counters[row] = lanes;
+        counting |= lanes != 0;
+        if (next != cooked[row]) {
+            cooked[row]    = next;
+            cooked_changed = true;
+            TRACE(TRACE_DEBOUNCE, row << 8 | next);
+        }
+    }
+    return cooked_changed;
+}
+
+void debounce_free(void) {}
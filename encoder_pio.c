@@ -0,0 +1,91 @@
+// RP2040 PIO quadrature decoder (ENCODER_DRIVER = custom).
+//
+// One state machine per encoder counts every A/B transition in hardware.
+// encoder_driver_task() reads the running count once per scan and queues
+// one event per `resolution` transitions. Anything the event queue cannot
+// take stays in the difference between the hardware count and what has been
+// reported, so it is delivered on the following scans instead of dropped.
+
+#include "quantum.h"
+#include "encoder.h"
+#include "hardware/pio.h"
+#include "quadrature_encoder.pio.h"
+
+#ifndef PIO_ENCODER_PIO
+#    define PIO_ENCODER_PIO pio1
+#endif
+
+static const pin_t   pins_a[]      = ENCODER_A_PINS;
+static const pin_t   pins_b[]      = ENCODER_B_PINS;
+static const uint8_t resolutions[] = ENCODER_RESOLUTIONS;
+
+#define ENCODERS ARRAY_SIZE(pins_a)
+
+static const pio_program_t quadrature_encoder_program = {
+    .instructions = quadrature_encoder_program_instructions,
+    .length       = ARRAY_SIZE(quadrature_encoder_program_instructions),
+    .origin       = 0,
+};
+
+static PIO     pio = PIO_ENCODER_PIO;
+static int     state_machines[ENCODERS];
+static int32_t reported[ENCODERS];
+
+void encoder_driver_init(void) {
+    pio_add_program_at_offset(pio, &quadrature_encoder_program, 0);
+
+    for (uint8_t i = 0; i < ENCODERS; i++) {
+        state_machines[i] = -1;
+
+        // The program samples A and B with one `in pins, 2`.
+        if (pins_b[i] != pins_a[i] + 1) {
+            dprintf("encoder %u: B must be the GPIO after A\n", i);
+            continue;
+        }
+
+        setPinInputHigh(pins_a[i]);
+        setPinInputHigh(pins_b[i]);
+
+        int           sm     = pio_claim_unused_sm(pio, true);
+        pio_sm_config config = pio_get_default_sm_config();
+        sm_config_set_wrap(&config, quadrature_encoder_wrap_target, quadrature_encoder_wrap);
+        sm_config_set_in_pins(&config, pins_a[i]);
+        sm_config_set_in_shift(&config, false, false, 32);
+        pio_sm_init(pio, sm, 0, &config);
+        pio_sm_set_enabled(pio, sm, true);
+
+        state_machines[i] = sm;
+    }
+}
+
+// The state machine pushes its count on every loop and drops pushes while
+// the FIFO is full, so flush the stale entries and take the next fresh one.
+static int32_t read_count(int sm) {
+    uint8_t n     = pio_sm_get_rx_fifo_level(pio, sm) + 1;
+    int32_t count = 0;
+    while (n--) {
+        count = (int32_t)pio_sm_get_blocking(pio, sm);
+    }
+    return count;
+}
+
+void encoder_driver_task(void) {
+    for (uint8_t i = 0; i < ENCODERS; i++) {
+        if (state_machines[i] < 0) {
+            continue;
+        }
+
+        int32_t pending = read_count(state_machines[i]) - reported[i];
+
+        while (pending >= resolutions[i] && !encoder_queue_full()) {
+            encoder_queue_event(i, ENCODER_COUNTER_CLOCKWISE);
+            reported[i] += resolutions[i];
+            pending -= resolutions[i];
+        }
+        while (pending <= -resolutions[i] && !encoder_queue_full()) {
+            encoder_queue_event(i, ENCODER_CLOCKWISE);
+            reported[i] -= resolutions[i];
+            pending += resolutions[i];
+        }
+    }
+}
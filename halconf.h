@@ -0,0 +1,6 @@
+#pragma once
+
+// Encoder button and idle wake-up edge interrupts (matrix.c)
+#define PAL_USE_CALLBACKS TRUE
+
+#include_next <halconf.h>
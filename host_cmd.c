@@ -0,0 +1,133 @@
+#include <string.h>
+#include "quantum.h"
+#include "host_cmd.h"
+#include "trace.h"
+#include "rgb_store.h"
+#include "keymap_cache.h"
+#include "boot_time.h"
+#ifdef POWER_SAVE_ENABLE
+#    include "power.h"
+#endif
+#ifdef REPORT_COALESCE_ENABLE
+#    include "report_coalesce.h"
+#endif
+#ifdef RGB_STREAM_ENABLE
+#    include "rgb_stream.h"
+#endif
+#ifdef PROFILES_ENABLE
+#    include "profile.h"
+#endif
+
+#ifdef RAW_ENABLE
+#    include "raw_hid.h"
+
+bool host_cmd_receive(uint8_t *data, uint8_t length) {
+#    ifdef POWER_SAVE_ENABLE
+    // Every raw HID packet, VIA's included, comes through here.
+    power_activity();
+#    endif
+    if (length < 4 || data[0] != HOST_CMD_ID) {
+        return false;
+    }
+
+    switch (data[1]) {
+#    ifdef LATENCY_TRACE_ENABLE
+        case HOST_CMD_TRACE_READ:
+            data[2] = trace_read(&data[4], length - 4, &data[3]);
+            break;
+        case HOST_CMD_LOOP_STATS:
+            if (length >= 4 + sizeof(trace_loop_stats_t)) {
+                trace_loop_stats_t stats;
+                trace_loop_stats(&stats);
+                memcpy(&data[4], &stats, sizeof(stats));
+                break;
+            }
+            data[1] = 0xFF;
+            break;
+#    endif
+        case HOST_CMD_RGB_STORE_STATS:
+            if (length >= 4 + sizeof(rgb_store_stats_t)) {
+                memcpy(&data[4], rgb_store_stats(), sizeof(rgb_store_stats_t));
+                break;
+            }
+            data[1] = 0xFF;
+            break;
+        case HOST_CMD_BOOT_TIMELINE:
+            if (length >= 4 + sizeof(boot_time_at)) {
+                data[2] = BOOT_PHASES;
+                data[3] = boot_time_reached;
+                memcpy(&data[4], boot_time_at, sizeof(boot_time_at));
+                break;
+            }
+            data[1] = 0xFF;
+            break;
+#    ifdef POWER_SAVE_ENABLE
+        case HOST_CMD_POWER_STATS:
+            if (length >= 4 + sizeof(power_stats_t) && data[2] < POWER_STATES) {
+                power_stats_t stats;
+                power_stats(data[2], &stats);
+                memcpy(&data[4], &stats, sizeof(stats));
+                break;
+            }
+            data[1] = 0xFF;
+            break;
+#    endif
+#    ifdef REPORT_COALESCE_ENABLE
+        case HOST_CMD_REPORT_STATS:
+            if (length >= 4 + sizeof(report_coalesce_stats_t)) {
+                memcpy(&data[4], report_coalesce_stats(), sizeof(report_coalesce_stats_t));
+                break;
+            }
+            data[1] = 0xFF;
+            break;
+#    endif
+#    ifdef RGB_STREAM_ENABLE
+        case HOST_CMD_LED_FRAME:
+            rgb_stream_receive(&data[2], length - 2);
+            return true;
+        case HOST_CMD_LED_STATS:
+            if (length >= 4 + sizeof(rgb_stream_stats_t)) {
+                memcpy(&data[4], rgb_stream_stats(), sizeof(rgb_stream_stats_t));
+                break;
+            }
+            data[1] = 0xFF;
+            break;
+#    endif
+#    ifdef PROFILES_ENABLE
+        case HOST_CMD_PROFILE:
+            if (length >= 4 + PROFILE_NAME_LEN && (data[2] == 0xFF || profile_select(data[2]))) {
+                uint8_t named = data[3] == 0xFF ? profile_current() : data[3];
+                data[2]       = profile_current();
+                data[3]       = profile_count();
+                memcpy(&data[4], profile_name(named), PROFILE_NAME_LEN);
+                break;
+            }
+            data[1] = 0xFF;
+            break;
+#    endif
+        default:
+            data[1] = 0xFF;
+            break;
+    }
+    raw_hid_send(data, length);
+    return true;
+}
+
+#    ifdef VIA_ENABLE
+bool via_command_kb(uint8_t *data, uint8_t length) {
+#        ifdef DYNAMIC_KEYMAP_ENABLE
+    // Never consumes the packet: VIA still writes the change to EEPROM.
+    keymap_cache_via_command(data, length);
+#        endif
+    return host_cmd_receive(data, length);
+}
+#    else
+void raw_hid_receive(uint8_t *data, uint8_t length) {
+    if (!host_cmd_receive(data, length)) {
+        data[0] = 0xFF;
+        raw_hid_send(data, length);
+    }
+}
+#    endif
+
+#endif
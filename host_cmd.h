@@ -0,0 +1,37 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Keyboard-specific raw HID commands. A packet is
+//   [0] HOST_CMD_ID  [1] command  [2..] payload
+// and is answered in place with the same two header bytes. With VIA these
+// ride on via_command_kb(), otherwise on raw_hid_receive().
+#define HOST_CMD_ID 0xF8
+
+enum host_cmd {
+    // -> [2] entries, [3] lost, [4..] entries of 8 bytes (trace_entry_t, LE)
+    HOST_CMD_TRACE_READ = 0x01,
+    // -> [4..19] rgb_store_stats_t (LE): writes, stall us total/max/last
+    HOST_CMD_RGB_STORE_STATS = 0x02,
+    // -> [4..27] trace_loop_stats_t (LE): XIP hits, XIP accesses, loops,
+    //    loop us min/max/total; restarts the counters
+    HOST_CMD_LOOP_STATS = 0x03,
+    // -> [2] phases, [3] reached mask, [4..] us per enum boot_phase (LE)
+    HOST_CMD_BOOT_TIMELINE = 0x04,
+    // [2] enum power_state -> [4..27] power_stats_t (LE): ms in state, ms
+    //    asleep, sleeps, edge wakes, wake-to-key us last/max
+    HOST_CMD_POWER_STATS = 0x05,
+    // -> [4..15] report_coalesce_stats_t (LE): reports in, out, kept apart
+    HOST_CMD_REPORT_STATS = 0x06,
+    // [2..] one packet of an LED frame, see rgb_stream.h. No reply.
+    HOST_CMD_LED_FRAME = 0x07,
+    // -> [4..19] rgb_stream_stats_t (LE): packets, frames, dropped, rejected
+    HOST_CMD_LED_STATS = 0x08,
+    // [2] profile to switch to, 0xFF to keep, [3] profile to name, 0xFF for
+    //    the current one -> [2] current, [3] count, [4..19] the name
+    HOST_CMD_PROFILE = 0x09,
+};
+
+// Handles a packet if it carries HOST_CMD_ID; returns false otherwise.
+bool host_cmd_receive(uint8_t *data, uint8_t length);
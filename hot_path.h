@@ -0,0 +1,18 @@
+#pragma once
+
+// Code placement on the RP2040. Functions in .time_critical.* are copied to
+// SRAM at boot (QMK's RP2040 linker script keeps them in .data, as the
+// pico-sdk does), so they never wait for the 16 KB XIP cache to refill from
+// QSPI flash.
+#ifndef __not_in_flash_func
+#    define __not_in_flash_func(name) __attribute__((section(".time_critical." #name))) name
+#endif
+
+// Scan-to-report path: matrix scan, debounce, keycode lookup and
+// process_record dispatch. Runs from SRAM with SRAM_HOT_PATH_ENABLE so RGB
+// effects or VIA handling cannot evict it from the XIP cache.
+#ifdef SRAM_HOT_PATH_ENABLE
+#    define HOT_PATH(name) __not_in_flash_func(name)
+#else
+#    define HOT_PATH(name) name
+#endif
@@ -0,0 +1,235 @@
+// Dynamic keymap mirrored in SRAM.
+//
+// With DYNAMIC_KEYMAP_ENABLE every keycode lookup is two eeprom_read_byte()
+// calls through the EEPROM driver into wear-leveling, all of it code in
+// flash, and QMK does a lookup per active layer for every key event. The
+// keymap is only 280 bytes, so keep a copy and index it directly.
+//
+// VIA's set keycode / set buffer / reset / EEPROM reset commands are
+// applied to the copy from via_command_kb(), which runs before VIA writes
+// the same change to EEPROM, so the two never disagree between key events.
+// QMK's own eeconfig_init() (EE_CLR) resets the keymap too; it ends in
+// eeconfig_init_kb(), which loads the copy again.
+//
+// With PROFILES_ENABLE keymap_key_to_keycode() reads the active profile's
+// table in flash instead, or the keymap itself for profile 0.
+//
+// On top of that every key keeps the keycode it resolves to under the
+// current layer state: the highest active layer where it is not KC_TRNS.
+// Each key also keeps the mask of layers where it is not transparent, so its
+// source layer is the top bit of (state & mask), and a layer change only
+// resolves again the keys whose mask has one of the changed layers in it.
+//
+// QMK's layer walk (layer_switch_get_layer()) starts at the highest active
+// layer, and keymap_key_to_keycode() answers that first lookup from the
+// table: the walk stops there and the keycode lookup after it reads the same
+// entry, so a press costs one table read whatever the layers. QMK keeps that
+// layer as the key's source for the release, by which time the layers may
+// have changed; keymap_cache_process() holds the press keycode for it until
+// then.
+
+#include <string.h>
+#include "quantum.h"
+#include "keymap_cache.h"
+#include "keymap_introspection.h"
+#include "hot_path.h"
+
+#ifdef DYNAMIC_KEYMAP_ENABLE
+#    include "dynamic_keymap.h"
+#    include "via.h"
+#endif
+
+#define NOT_HELD UINT8_MAX
+
+static layer_state_t opaque[MATRIX_ROWS][MATRIX_COLS];
+static uint16_t      effective[MATRIX_ROWS][MATRIX_COLS];
+static uint8_t       source[MATRIX_ROWS][MATRIX_COLS];
+static layer_state_t resolved_state;
+static uint8_t       top_layer;
+
+// Keycode of a held key and the layer QMK will release it from.
+static uint16_t held_keycode[MATRIX_ROWS][MATRIX_COLS];
+static uint8_t  held_layer[MATRIX_ROWS][MATRIX_COLS];
+
+static void keymap_cache_rebuild(void);
+
+#if defined(DYNAMIC_KEYMAP_ENABLE) || defined(PROFILES_ENABLE)
+static const uint16_t (*profile_table)[MATRIX_ROWS][MATRIX_COLS] = NULL;
+static uint8_t profile_layers;
+#endif
+
+#ifdef DYNAMIC_KEYMAP_ENABLE
+
+static uint16_t keymap_ram[DYNAMIC_KEYMAP_LAYER_COUNT][MATRIX_ROWS][MATRIX_COLS];
+
+static void keymap_cache_load(void) {
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                keymap_ram[layer][row][col] = dynamic_keymap_get_keycode(layer, row, col);
+            }
+        }
+    }
+}
+
+// Same defaults dynamic_keymap_reset() writes to EEPROM.
+static void keymap_cache_reset(void) {
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                keymap_ram[layer][row][col] = layer < keymap_layer_count() ? keycode_at_keymap_location_raw(layer, row, col) : KC_TRANSPARENT;
+            }
+        }
+    }
+}
+
+// The EEPROM image stores each keycode big endian, in the same
+// [layer][row][col] order as keymap_ram.
+static void keymap_cache_set_buffer(uint16_t offset, uint8_t size, const uint8_t *bytes) {
+    uint16_t *flat = &keymap_ram[0][0][0];
+
+    for (uint8_t i = 0; i < size && offset + i < sizeof(keymap_ram); i++) {
+        uint16_t pos = offset + i;
+        if (pos & 1) {
+            flat[pos >> 1] = (flat[pos >> 1] & 0xFF00) | bytes[i];
+        } else {
+            flat[pos >> 1] = (flat[pos >> 1] & 0x00FF) | bytes[i] << 8;
+        }
+    }
+}
+
+void keymap_cache_via_command(const uint8_t *data, uint8_t length) {
+    switch (data[0]) {
+        case id_dynamic_keymap_set_keycode:
+            if (data[1] < DYNAMIC_KEYMAP_LAYER_COUNT && data[2] < MATRIX_ROWS && data[3] < MATRIX_COLS) {
+                keymap_ram[data[1]][data[2]][data[3]] = data[4] << 8 | data[5];
+            }
+            break;
+        case id_dynamic_keymap_set_buffer:
+            if (length > 4) {
+                keymap_cache_set_buffer(data[1] << 8 | data[2], MIN(data[3], length - 4), &data[4]);
+            }
+            break;
+        case id_dynamic_keymap_reset:
+        case id_eeprom_reset: // eeconfig_init_via() ends in dynamic_keymap_reset()
+            keymap_cache_reset();
+            break;
+        default:
+            return;
+    }
+    keymap_cache_rebuild();
+}
+
+void keymap_cache_reload(void) {
+    keymap_cache_load();
+    keymap_cache_rebuild();
+}
+
+#endif
+
+// What the keymap (or profile) has on one layer.
+static uint16_t HOT_PATH(keymap_cache_lookup)(uint8_t layer, keypos_t key) {
+#if defined(DYNAMIC_KEYMAP_ENABLE) || defined(PROFILES_ENABLE)
+    if (profile_table) {
+        return layer < profile_layers ? profile_table[layer][key.row][key.col] : KC_TRNS;
+    }
+#endif
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    return layer < DYNAMIC_KEYMAP_LAYER_COUNT ? keymap_ram[layer][key.row][key.col] : KC_NO;
+#else
+    return keycode_at_keymap_location_raw(layer, key.row, key.col);
+#endif
+}
+
+// Only reads the keymap when the source layer moves.
+static void resolve(uint8_t row, uint8_t col) {
+    layer_state_t active = resolved_state & opaque[row][col];
+    uint8_t       layer  = active ? get_highest_layer(active) : 0;
+
+    if (layer == source[row][col]) {
+        return;
+    }
+    source[row][col]    = layer;
+    effective[row][col] = keymap_cache_lookup(layer, (keypos_t){.row = row, .col = col});
+}
+
+static void keymap_cache_rebuild(void) {
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            layer_state_t mask = 0;
+            for (uint8_t layer = 0; layer < MAX_LAYER; layer++) {
+                if (keymap_cache_lookup(layer, (keypos_t){.row = row, .col = col}) != KC_TRNS) {
+                    mask |= (layer_state_t)1 << layer;
+                }
+            }
+            opaque[row][col] = mask;
+            source[row][col] = UINT8_MAX;
+            resolve(row, col);
+        }
+    }
+}
+
+void keymap_cache_set_layers(layer_state_t state) {
+    layer_state_t changed = state ^ resolved_state;
+
+    resolved_state = state;
+    top_layer      = get_highest_layer(state);
+    if (!changed) {
+        return;
+    }
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            if (opaque[row][col] & changed) {
+                resolve(row, col);
+            }
+        }
+    }
+}
+
+uint16_t HOT_PATH(keymap_key_to_keycode)(uint8_t layer, keypos_t key) {
+    if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return KC_NO;
+    }
+    if (layer == held_layer[key.row][key.col]) {
+        return held_keycode[key.row][key.col];
+    }
+    if (layer == top_layer) {
+        return effective[key.row][key.col];
+    }
+    return keymap_cache_lookup(layer, key);
+}
+
+void HOT_PATH(keymap_cache_process)(uint16_t keycode, const keyrecord_t *record) {
+    keypos_t key = record->event.key;
+
+    // Combos and other synthetic events sit outside the matrix.
+    if (key.row >= MATRIX_ROWS || key.col >= MATRIX_COLS) {
+        return;
+    }
+    // A press QMK resolved from the table is released from top_layer.
+    bool from_table = record->event.pressed && keycode != KC_TRNS && keycode == effective[key.row][key.col];
+
+    held_layer[key.row][key.col]   = from_table ? top_layer : NOT_HELD;
+    held_keycode[key.row][key.col] = keycode;
+}
+
+#if defined(DYNAMIC_KEYMAP_ENABLE) || defined(PROFILES_ENABLE)
+void keymap_cache_use(const uint16_t (*table)[MATRIX_ROWS][MATRIX_COLS], uint8_t layers) {
+    profile_table  = table;
+    profile_layers = layers;
+    keymap_cache_rebuild();
+}
+#endif
+
+void keymap_cache_init(void) {
+#if defined(DYNAMIC_KEYMAP_ENABLE) || defined(PROFILES_ENABLE)
+    profile_table = NULL;
+#endif
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    keymap_cache_load();
+#endif
+    memset(held_layer, NOT_HELD, sizeof(held_layer));
+    resolved_state = layer_state | default_layer_state;
+    top_layer      = get_highest_layer(resolved_state);
+    keymap_cache_rebuild();
+}
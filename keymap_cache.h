@@ -0,0 +1,39 @@
+#pragma once
+
+#include "quantum.h"
+
+// SRAM copy of the dynamic keymap, plus the keycode each key resolves to
+// under the current layer state. With a dynamic keymap
+// keymap_key_to_keycode() reads the copy instead of going through the EEPROM
+// emulation; VIA keymap writes update it before VIA writes them to flash.
+// A lookup of the highest active layer returns the resolved keycode, so
+// QMK's layer walk ends at its first step.
+
+// Loads the dynamic keymap from EEPROM and resolves every key. Called once
+// after via_init().
+void keymap_cache_init(void);
+
+// Resolves again the keys a layer change affects. state is
+// layer_state | default_layer_state.
+void keymap_cache_set_layers(layer_state_t state);
+
+// From process_record_kb(), for every event that gets there: keeps the
+// keycode of a press resolved from the table for its release, which QMK
+// looks up on the layer that was highest at the press. Never consumes the
+// event.
+void keymap_cache_process(uint16_t keycode, const keyrecord_t *record);
+
+// Profiles only (profile.c): keymap lookups read layers x MATRIX_ROWS x
+// MATRIX_COLS keycodes from table, or the keymap itself for NULL, and every
+// key is resolved again.
+void keymap_cache_use(const uint16_t (*table)[MATRIX_ROWS][MATRIX_COLS], uint8_t layers);
+
+// Mirrors a VIA keymap write (set keycode, set buffer, reset, EEPROM reset)
+// into SRAM. Called from via_command_kb() ahead of VIA's own handling;
+// ignores every other command.
+void keymap_cache_via_command(const uint8_t *data, uint8_t length);
+
+// Loads the dynamic keymap from EEPROM again after QMK rewrote it outside
+// VIA's commands (EE_CLR, an invalid EEPROM at boot). Called from
+// eeconfig_init_kb().
+void keymap_cache_reload(void);
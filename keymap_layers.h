@@ -0,0 +1,74 @@
+// Generated by tools/gen_tables.py from layers.json and keyboard.json, do not edit.
+// Included once, by keymap.c, after its custom keycodes.
+
+#pragma once
+
+#define KEYMAP_LAYER_COUNT 5
+
+// The copies in config.h and the simulator.
+_Static_assert(MATRIX_ROWS == 7 && MATRIX_COLS == 4, "matrix size differs from keyboard.json");
+#ifdef RGBLIGHT_LED_COUNT
+_Static_assert(RGBLIGHT_LED_COUNT == 10, "RGBLIGHT_LED_COUNT differs from keyboard.json");
+#endif
+#ifdef DYNAMIC_KEYMAP_LAYER_COUNT
+_Static_assert(DYNAMIC_KEYMAP_LAYER_COUNT == KEYMAP_LAYER_COUNT, "DYNAMIC_KEYMAP_LAYER_COUNT differs from layers.json");
+#endif
+#ifdef LAYER_STATE_8BIT
+_Static_assert(KEYMAP_LAYER_COUNT <= 8, "LAYER_STATE_8BIT holds 8 layers");
+#endif
+#ifdef ENCODER_BTN_ROW
+_Static_assert(ENCODER_BTN_ROW == 6 && ENCODER_BTN_COL == 0, "the encoder button is not the layout's key past the matrix pins");
+#endif
+
+const uint16_t PROGMEM keymaps[KEYMAP_LAYER_COUNT][MATRIX_ROWS][MATRIX_COLS] = {
+    // numpad
+    [0] = LAYOUT_6x4(
+        KC_NO,      MO(1),      MO(4),      KC_BSPC,
+        KC_NUM,     KC_PAST,    KC_PSLS,    KC_PMNS,
+        KC_P7,      KC_P8,      KC_P9,      KC_PPLS,
+        KC_P4,      KC_P5,      KC_P6,      KC_NO,
+        KC_P1,      KC_P2,      KC_P3,      KC_PENT,
+        KC_NO,      KC_P0,      KC_PDOT,    KC_NO,
+        RGB_UI_TOG
+    ),
+    // editing
+    [1] = LAYOUT_6x4(
+        KC_NO,                  TO(0),                  MO(4),                  KC_BSPC,
+        SEQ_COPY_WORD,          SEQ_COPY_LINE,          SEQ_DUP_LINE,           LCTL(KC_A),
+        LCTL(KC_Z),             S(KC_HOME),             LCTL(KC_R),             LCTL(KC_C),
+        S(KC_LEFT),             LCTL(KC_S),             S(KC_RGHT),             KC_NO,
+        LCTL(LSFT(KC_LEFT)),    S(KC_END),              LCTL(LSFT(KC_RGHT)),    KC_PENT,
+        KC_NO,                  KC_SPACE,               LCTL(KC_X),             KC_NO,
+        KC_TRNS
+    ),
+    // windows
+    [2] = LAYOUT_6x4(
+        KC_NO,                  MO(0),                  MO(4),                  KC_NO,
+        MS_LEFT,                MS_DOWN,                MS_UP,                  MS_RGHT,
+        LALT(LCTL(KC_LEFT)),    KC_NO,                  LALT(LCTL(KC_RGHT)),    KC_NO,
+        LCTL(LGUI(KC_LEFT)),    KC_NO,                  LCTL(LGUI(KC_RGHT)),    KC_NO,
+        MS_BTN1,                MS_BTN2,                KC_NO,                  KC_PENT,
+        KC_NO,                  KC_NO,                  LCTL(LALT(KC_DEL)),     KC_NO,
+        KC_TRNS
+    ),
+    // function keys
+    [3] = LAYOUT_6x4(
+        KC_NO,      TO(0),      MO(4),      KC_NO,
+        KC_NO,      KC_NO,      KC_NO,      KC_NO,
+        KC_F14,     KC_F15,     KC_F16,     KC_NO,
+        KC_F17,     KC_F18,     KC_F19,     KC_NO,
+        KC_F20,     KC_F21,     KC_F22,     KC_NO,
+        KC_NO,      KC_NO,      KC_NO,      KC_NO,
+        KC_TRNS
+    ),
+    // rgb
+    [4] = LAYOUT_6x4(
+        KC_NO,              TO(0),              MO(4),              KC_NO,
+        RGB_UI_WSPD_UP,     RGB_UI_WSPD_DN,     RGB_UI_HUI,         RGB_UI_HUD,
+        RGB_UI_VAI,         RGB_UI_VAD,         RGB_UI_WTOG,        RGB_UI_TOG,
+        RGB_UI_SAI,         RGB_UI_SAD,         PF_NEXT,            KC_NO,
+        TO(1),              TO(2),              TO(3),              KC_NO,
+        KC_NO,              KC_NO,              KC_NO,              KC_NO,
+        KC_TRNS
+    ),
+};
@@ -0,0 +1,107 @@
+// Keystroke sequences played from the main loop. tap_code16() and
+// SEND_STRING send their reports back to back with wait_ms() in between, and
+// on ChibiOS every report after the first waits for the host to poll the
+// endpoint, so a long macro holds the scan loop for several milliseconds.
+// Here a sequence is queued as single-report steps and macro_seq_task()
+// sends one per MACRO_SEQ_STEP_MS, while scanning goes on.
+
+#include "quantum.h"
+#include "macro_seq.h"
+#include "trace.h"
+
+_Static_assert(MACRO_SEQ_QUEUE_SIZE <= 128 && (MACRO_SEQ_QUEUE_SIZE & (MACRO_SEQ_QUEUE_SIZE - 1)) == 0, "MACRO_SEQ_QUEUE_SIZE must be a power of two up to 128");
+
+// A step is one report: a basic keycode, or with MACRO_SEQ_MODS_BIT a
+// modifier mask, pressed or (MACRO_SEQ_UP_BIT) released. A keycode with
+// modifiers becomes two steps, so no call ever sends two reports and waits
+// for the host to poll in between.
+#define MACRO_SEQ_UP_BIT 0x8000
+#define MACRO_SEQ_MODS_BIT 0x4000
+
+static uint16_t queue[MACRO_SEQ_QUEUE_SIZE];
+static uint8_t  head     = 0;
+static uint8_t  tail     = 0;
+static uint16_t step_tmr = 0;
+
+static uint8_t queued(void) {
+    return (uint8_t)(head - tail);
+}
+
+static void push(uint16_t step) {
+    queue[head++ & (MACRO_SEQ_QUEUE_SIZE - 1)] = step;
+}
+
+// QK_MODS_GET_MODS() packs right-hand modifiers as bit 4 plus the left-hand
+// bits; the report wants them in the upper nibble.
+static uint8_t mod_bits(uint16_t keycode) {
+    uint8_t mods = QK_MODS_GET_MODS(keycode);
+    return mods & 0x10 ? (mods & 0x0F) << 4 : mods;
+}
+
+static uint8_t steps_for(const macro_step_t *step) {
+    uint8_t steps = mod_bits(step->keycode) ? 2 : 1;
+    return step->action == MACRO_SEQ_TAP ? steps * 2 : steps;
+}
+
+static void push_down(uint16_t keycode) {
+    if (mod_bits(keycode)) {
+        push(MACRO_SEQ_MODS_BIT | mod_bits(keycode));
+    }
+    push(QK_MODS_GET_BASIC_KEYCODE(keycode));
+}
+
+static void push_up(uint16_t keycode) {
+    push(MACRO_SEQ_UP_BIT | QK_MODS_GET_BASIC_KEYCODE(keycode));
+    if (mod_bits(keycode)) {
+        push(MACRO_SEQ_UP_BIT | MACRO_SEQ_MODS_BIT | mod_bits(keycode));
+    }
+}
+
+bool macro_seq_play(const macro_step_t *steps, uint8_t count) {
+    uint16_t needed = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        needed += steps_for(&steps[i]);
+    }
+    if (queued() + needed > MACRO_SEQ_QUEUE_SIZE) {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (steps[i].action != MACRO_SEQ_UP) {
+            push_down(steps[i].keycode);
+        }
+        if (steps[i].action != MACRO_SEQ_DOWN) {
+            push_up(steps[i].keycode);
+        }
+    }
+    return true;
+}
+
+bool macro_seq_busy(void) {
+    return queued() != 0;
+}
+
+void macro_seq_task(void) {
+    if (!queued() || timer_elapsed(step_tmr) < MACRO_SEQ_STEP_MS) {
+        return;
+    }
+
+    uint16_t step = queue[tail++ & (MACRO_SEQ_QUEUE_SIZE - 1)];
+    TRACE(TRACE_MACRO_STEP, step);
+    switch (step & (MACRO_SEQ_UP_BIT | MACRO_SEQ_MODS_BIT)) {
+        case 0:
+            register_code(step & 0xFF);
+            break;
+        case MACRO_SEQ_UP_BIT:
+            unregister_code(step & 0xFF);
+            break;
+        case MACRO_SEQ_MODS_BIT:
+            register_mods(step & 0xFF);
+            break;
+        default:
+            unregister_mods(step & 0xFF);
+            break;
+    }
+    step_tmr = timer_read();
+}
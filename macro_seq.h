@@ -0,0 +1,42 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Minimum time between two reports. The host polls the keyboard endpoint
+// every USB_POLLING_INTERVAL_MS, so each one is collected before the next.
+#ifndef MACRO_SEQ_STEP_MS
+#    define MACRO_SEQ_STEP_MS 1
+#endif
+
+// Reports waiting to be sent: a tap is two, four with modifiers. A power of
+// two up to 128.
+#ifndef MACRO_SEQ_QUEUE_SIZE
+#    define MACRO_SEQ_QUEUE_SIZE 64
+#endif
+
+enum macro_seq_action {
+    MACRO_SEQ_DOWN,
+    MACRO_SEQ_UP,
+    MACRO_SEQ_TAP,
+};
+
+typedef struct {
+    uint8_t  action;
+    uint16_t keycode;
+} macro_step_t;
+
+#define SEQ_DOWN(kc) {MACRO_SEQ_DOWN, (kc)}
+#define SEQ_UP(kc) {MACRO_SEQ_UP, (kc)}
+#define SEQ_TAP(kc) {MACRO_SEQ_TAP, (kc)}
+
+// Queues a sequence of basic keycodes, modifiers included (LCTL(KC_C)).
+// Returns without blocking; false if the queue has no room for all of it,
+// in which case nothing is queued.
+bool macro_seq_play(const macro_step_t *steps, uint8_t count);
+
+// True while reports are waiting.
+bool macro_seq_busy(void);
+
+// Sends at most one report per MACRO_SEQ_STEP_MS.
+void macro_seq_task(void);
@@ -0,0 +1,173 @@
+// Custom "lite" matrix: the physical 6x4 ROW2COL matrix plus one virtual row
+// holding the encoder push button.
+//
+// The button is not polled. A GPIO edge interrupt flags it and the next scan
+// reads the pin once into ENCODER_BTN_ROW, where the normal matrix debounce
+// filters it like any other key. While the button is idle the scan only
+// checks that flag.
+
+#include "quantum.h"
+#include "matrix.h"
+#include "trace.h"
+#include "hot_path.h"
+#ifdef PIO_MATRIX_ENABLE
+#    include "matrix_pio.h"
+#endif
+#ifdef POWER_SAVE_ENABLE
+#    include "power.h"
+#endif
+
+static const pin_t row_pins[] = MATRIX_ROW_PINS;
+static const pin_t col_pins[] = MATRIX_COL_PINS;
+
+_Static_assert(ARRAY_SIZE(row_pins) < MATRIX_ROWS, "MATRIX_ROWS must include the virtual row");
+
+#ifdef ENCODER_BTN_PIN
+static volatile bool btn_edge = true;
+
+static void encoder_btn_isr(void *arg) {
+    btn_edge = true;
+#    ifdef POWER_SAVE_ENABLE
+    power_wake_isr(arg);
+#    else
+    (void)arg;
+#    endif
+}
+
+static bool HOT_PATH(scan_encoder_btn)(matrix_row_t current_matrix[]) {
+    if (!btn_edge) {
+        return false;
+    }
+    // Clear before reading: an edge after this point is picked up next scan.
+    btn_edge = false;
+
+    matrix_row_t cols = readPin(ENCODER_BTN_PIN) ? 0 : (1 << ENCODER_BTN_COL);
+    if (current_matrix[ENCODER_BTN_ROW] == cols) {
+        return false;
+    }
+    current_matrix[ENCODER_BTN_ROW] = cols;
+    TRACE(TRACE_MATRIX, ENCODER_BTN_ROW << 8 | cols);
+    return true;
+}
+#endif
+
+#ifndef PIO_MATRIX_ENABLE
+// ROW2COL: the diodes only conduct from a row into a driven column, so each
+// column is pulled low in turn and the pressed keys read low on their rows.
+static bool HOT_PATH(scan_cols)(matrix_row_t current_matrix[]) {
+    matrix_row_t next[ARRAY_SIZE(row_pins)] = {0};
+    bool         changed                    = false;
+
+    for (uint8_t col = 0; col < ARRAY_SIZE(col_pins); col++) {
+        setPinOutput(col_pins[col]);
+        writePinLow(col_pins[col]);
+        matrix_output_select_delay();
+
+        bool any = false;
+        for (uint8_t row = 0; row < ARRAY_SIZE(row_pins); row++) {
+            if (!readPin(row_pins[row])) {
+                next[row] |= (matrix_row_t)1 << col;
+                any = true;
+            }
+        }
+
+        setPinInputHigh(col_pins[col]);
+        matrix_output_unselect_delay(col, any);
+    }
+
+    for (uint8_t row = 0; row < ARRAY_SIZE(row_pins); row++) {
+        if (current_matrix[row] != next[row]) {
+            current_matrix[row] = next[row];
+            changed             = true;
+            TRACE(TRACE_MATRIX, row << 8 | next[row]);
+        }
+    }
+    return changed;
+}
+#endif
+
+#ifdef POWER_SAVE_ENABLE
+#    ifdef ENCODER_A_PINS
+static const pin_t encoder_pins_a[] = ENCODER_A_PINS;
+static const pin_t encoder_pins_b[] = ENCODER_B_PINS;
+
+static void arm_encoder(pin_t pin) {
+    palEnableLineEvent(pin, PAL_EVENT_MODE_BOTH_EDGES);
+    palSetLineCallback(pin, power_wake_isr, NULL);
+}
+#    endif
+
+// With every column low any press pulls its row low through the diode, so
+// one falling edge per row covers the whole matrix.
+bool matrix_wake_arm(void) {
+    for (uint8_t col = 0; col < ARRAY_SIZE(col_pins); col++) {
+        setPinOutput(col_pins[col]);
+        writePinLow(col_pins[col]);
+    }
+    for (uint8_t row = 0; row < ARRAY_SIZE(row_pins); row++) {
+        palEnableLineEvent(row_pins[row], PAL_EVENT_MODE_FALLING_EDGE);
+        palSetLineCallback(row_pins[row], power_wake_isr, NULL);
+    }
+#    ifdef ENCODER_A_PINS
+    for (uint8_t i = 0; i < ARRAY_SIZE(encoder_pins_a); i++) {
+        arm_encoder(encoder_pins_a[i]);
+        arm_encoder(encoder_pins_b[i]);
+    }
+#    endif
+    matrix_output_select_delay();
+
+    // A key that is already down never makes an edge.
+    for (uint8_t row = 0; row < ARRAY_SIZE(row_pins); row++) {
+        if (!readPin(row_pins[row])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void matrix_wake_disarm(void) {
+    for (uint8_t row = 0; row < ARRAY_SIZE(row_pins); row++) {
+        palDisableLineEvent(row_pins[row]);
+    }
+#    ifdef ENCODER_A_PINS
+    for (uint8_t i = 0; i < ARRAY_SIZE(encoder_pins_a); i++) {
+        palDisableLineEvent(encoder_pins_a[i]);
+        palDisableLineEvent(encoder_pins_b[i]);
+    }
+#    endif
+    for (uint8_t col = 0; col < ARRAY_SIZE(col_pins); col++) {
+        setPinInputHigh(col_pins[col]);
+    }
+}
+#endif
+
+void matrix_init_custom(void) {
+#ifdef PIO_MATRIX_ENABLE
+    pio_matrix_init();
+#else
+    for (uint8_t row = 0; row < ARRAY_SIZE(row_pins); row++) {
+        setPinInputHigh(row_pins[row]);
+    }
+    for (uint8_t col = 0; col < ARRAY_SIZE(col_pins); col++) {
+        setPinInputHigh(col_pins[col]);
+    }
+#endif
+
+#ifdef ENCODER_BTN_PIN
+    setPinInputHigh(ENCODER_BTN_PIN);
+    palEnableLineEvent(ENCODER_BTN_PIN, PAL_EVENT_MODE_BOTH_EDGES);
+    palSetLineCallback(ENCODER_BTN_PIN, encoder_btn_isr, NULL);
+#endif
+}
+
+bool HOT_PATH(matrix_scan_custom)(matrix_row_t current_matrix[]) {
+#ifdef PIO_MATRIX_ENABLE
+    bool changed = pio_matrix_scan(current_matrix);
+#else
+    bool changed = scan_cols(current_matrix);
+#endif
+#ifdef ENCODER_BTN_PIN
+    changed |= scan_encoder_btn(current_matrix);
+#endif
+    return changed;
+}
@@ -0,0 +1,180 @@
+// RP2040 PIO + DMA scanner for the physical rows of the matrix (matrix.c).
+//
+// The diodes point from rows to columns (ROW2COL), so a PIO state machine
+// drives one column low at a time through the pin directions and samples
+// the rows, eight pins from the first row pin. The four column slots make up
+// one 32-bit snapshot, a byte per column, that is autopushed to the RX FIFO.
+// One DMA channel feeds the column patterns from a ring, a second one copies
+// every snapshot into a RAM ring, so the CPU only has to compare the newest
+// word with the last one it saw.
+//
+// Requires the row pins and the column pins to be consecutive GPIOs.
+
+#include "quantum.h"
+#include "matrix_pio.h"
+#include "trace.h"
+#include "hot_path.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+
+#ifndef PIO_MATRIX_PIO
+#    define PIO_MATRIX_PIO pio1
+#endif
+
+#ifndef PIO_MATRIX_SCAN_HZ
+#    define PIO_MATRIX_SCAN_HZ 40000
+#endif
+
+#define SLOTS 4
+#define CYCLES_PER_SLOT 33
+#define RING_WORDS 16
+#define RING_SIZE_BITS 6
+#define PATTERN_RING_SIZE_BITS 4
+#define COUNT_REARM 0x10000000u
+
+// out pindirs, 4 [31]  ; select the column, then let the rows settle
+// in pins, 8           ; sample the rows
+static const uint16_t matrix_scan_program_instructions[] = {
+    0x7f84,
+    0x4008,
+};
+
+static const pio_program_t matrix_scan_program = {
+    .instructions = matrix_scan_program_instructions,
+    .length       = ARRAY_SIZE(matrix_scan_program_instructions),
+    .origin       = -1,
+};
+
+static const pin_t row_pins[] = MATRIX_ROW_PINS;
+static const pin_t col_pins[] = MATRIX_COL_PINS;
+
+#define ROWS ARRAY_SIZE(row_pins)
+#define COLS ARRAY_SIZE(col_pins)
+
+_Static_assert(COLS == SLOTS && ROWS <= 8, "snapshot layout is one byte per column");
+
+static uint32_t col_patterns[SLOTS] __attribute__((aligned(SLOTS * sizeof(uint32_t))));
+static volatile uint32_t snapshots[RING_WORDS] __attribute__((aligned(RING_WORDS * sizeof(uint32_t))));
+
+static PIO                      pio = PIO_MATRIX_PIO;
+static int                      state_machine;
+static const rp_dma_channel_t  *dma_tx;
+static const rp_dma_channel_t  *dma_rx;
+
+static uint32_t last_snapshot = 0xFFFFFFFF;
+static uint32_t scan_base     = 0;
+static uint32_t rate_count    = 0;
+static uint32_t rate_hz       = 0;
+static uint16_t rate_tmr      = 0;
+
+static void dma_start(const rp_dma_channel_t *channel, uint32_t source, uint32_t destination, uint32_t mode) {
+    dmaChannelSetSourceX(channel, source);
+    dmaChannelSetDestinationX(channel, destination);
+    dmaChannelSetCounterX(channel, 0xFFFFFFFF);
+    dmaChannelSetModeX(channel, mode);
+    dmaChannelEnableX(channel);
+}
+
+static void dma_rx_start(void) {
+    dma_start(dma_rx, (uint32_t)&pio->rxf[state_machine], (uint32_t)snapshots, DMA_CTRL_TRIG_INCR_WRITE | DMA_CTRL_TRIG_DATA_SIZE_WORD | DMA_CTRL_TRIG_RING_SEL | DMA_CTRL_TRIG_RING_SIZE(RING_SIZE_BITS) | DMA_CTRL_TRIG_TREQ_SEL(pio_get_dreq(pio, state_machine, false)));
+}
+
+void pio_matrix_init(void) {
+    for (uint8_t col = 0; col < COLS; col++) {
+        col_patterns[col] = 1u << col;
+        // Pulled up like in matrix.c: the pad's reset pull-down would hold
+        // an undriven column low and leave a pressed key's row half way.
+        setPinInputHigh(col_pins[col]);
+        pio_gpio_init(pio, col_pins[col]);
+    }
+    for (uint8_t row = 0; row < ROWS; row++) {
+        setPinInputHigh(row_pins[row]);
+    }
+    for (uint8_t i = 0; i < RING_WORDS; i++) {
+        snapshots[i] = last_snapshot;
+    }
+
+    state_machine   = pio_claim_unused_sm(pio, true);
+    uint32_t offset = pio_add_program(pio, &matrix_scan_program);
+
+    // Columns only ever drive low; selecting a column means turning its pin
+    // into an output.
+    pio_sm_set_pins_with_mask(pio, state_machine, 0, ((1u << COLS) - 1) << col_pins[0]);
+    pio_sm_set_consecutive_pindirs(pio, state_machine, col_pins[0], COLS, false);
+
+    pio_sm_config config = pio_get_default_sm_config();
+    sm_config_set_wrap(&config, offset, offset + matrix_scan_program.length - 1);
+    sm_config_set_out_pins(&config, col_pins[0], COLS);
+    sm_config_set_in_pins(&config, row_pins[0]);
+    sm_config_set_out_shift(&config, true, true, COLS);
+    sm_config_set_in_shift(&config, true, true, 32);
+    sm_config_set_clkdiv(&config, (float)clock_get_hz(clk_sys) / (SLOTS * CYCLES_PER_SLOT * PIO_MATRIX_SCAN_HZ));
+    pio_sm_init(pio, state_machine, offset, &config);
+
+    dma_tx = dmaChannelAllocI(RP_DMA_CHANNEL_ID_ANY, 2, NULL, NULL);
+    dma_rx = dmaChannelAllocI(RP_DMA_CHANNEL_ID_ANY, 2, NULL, NULL);
+    dma_start(dma_tx, (uint32_t)col_patterns, (uint32_t)&pio->txf[state_machine], DMA_CTRL_TRIG_INCR_READ | DMA_CTRL_TRIG_DATA_SIZE_WORD | DMA_CTRL_TRIG_RING_SIZE(PATTERN_RING_SIZE_BITS) | DMA_CTRL_TRIG_TREQ_SEL(pio_get_dreq(pio, state_machine, true)));
+    dma_rx_start();
+
+    pio_sm_set_enabled(pio, state_machine, true);
+    rate_tmr = timer_read();
+}
+
+uint32_t pio_matrix_scan_count(void) {
+    return scan_base + (0xFFFFFFFF - dma_rx->channel->TRANS_COUNT);
+}
+
+uint32_t pio_matrix_scan_rate(void) {
+    return rate_hz;
+}
+
+static void update_scan_rate(void) {
+    if (timer_elapsed(rate_tmr) < 1000) {
+        return;
+    }
+    rate_tmr += 1000;
+
+    // Restart the snapshot channel long before its transfer count runs out.
+    // The RX FIFO covers the few cycles it is stopped.
+    if (dma_rx->channel->TRANS_COUNT < COUNT_REARM) {
+        uint32_t count = pio_matrix_scan_count();
+        dmaChannelDisableX(dma_rx);
+        scan_base = count;
+        dma_rx_start();
+    }
+
+    uint32_t count = pio_matrix_scan_count();
+    rate_hz        = count - rate_count;
+    rate_count     = count;
+    if (debug_matrix) {
+        dprintf("pio matrix: %lu scans/s\n", rate_hz);
+    }
+}
+
+bool HOT_PATH(pio_matrix_scan)(matrix_row_t current_matrix[]) {
+    update_scan_rate();
+
+    uint32_t next     = ((dma_rx->channel->WRITE_ADDR - (uint32_t)snapshots) / sizeof(uint32_t)) % RING_WORDS;
+    uint32_t snapshot = snapshots[(next + RING_WORDS - 1) % RING_WORDS];
+    if (snapshot == last_snapshot) {
+        return false;
+    }
+    last_snapshot = snapshot;
+
+    // Rows are pulled up, so a pressed key reads low. Byte c holds the rows
+    // seen with column c selected; bits past the row pins are not rows.
+    uint32_t pressed = ~snapshot;
+    bool     changed = false;
+    for (uint8_t row = 0; row < ROWS; row++) {
+        matrix_row_t cols = 0;
+        for (uint8_t col = 0; col < COLS; col++) {
+            cols |= (matrix_row_t)((pressed >> (col * 8 + row)) & 1) << col;
+        }
+        if (current_matrix[row] != cols) {
+            current_matrix[row] = cols;
+            changed             = true;
+            TRACE(TRACE_MATRIX, row << 8 | cols);
+        }
+    }
+    return changed;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "matrix.h"
+
+void pio_matrix_init(void);
+
+// Updates the physical rows from the newest snapshot; true if any changed.
+bool pio_matrix_scan(matrix_row_t current_matrix[]);
+
+// Total number of full matrix snapshots taken by the PIO scanner.
+uint32_t pio_matrix_scan_count(void);
+
+// Snapshots per second, measured over the last full second.
+uint32_t pio_matrix_scan_rate(void);
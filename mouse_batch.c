@@ -0,0 +1,116 @@
+// Batched wheel reports for the encoder: one report carrying the summed
+// delta per MOUSE_BATCH_INTERVAL_MS instead of a press and a release report
+// per detent. With POINTING_DEVICE_HIRES_SCROLL_ENABLE each detent is sent
+// as POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER high-resolution units, so hosts
+// that honour the resolution multiplier scroll smoothly.
+//
+// This is also the one place that sends mouse reports for the keyboard: the
+// wheel delta and mouse_motion.c's movement share a report, and no USB frame
+// gets more than one.
+
+#include "quantum.h"
+#include "mouse_batch.h"
+#include "mouse_motion.h"
+#include "trace.h"
+#include "hardware/structs/usb.h"
+
+#ifdef MOUSE_ENABLE
+
+#ifdef POINTING_DEVICE_HIRES_SCROLL_ENABLE
+#    define WHEEL_UNITS_PER_DETENT POINTING_DEVICE_HIRES_SCROLL_MULTIPLIER
+#else
+#    define WHEEL_UNITS_PER_DETENT 1
+#endif
+
+#ifdef WHEEL_EXTENDED_REPORT
+#    define WHEEL_MAX INT16_MAX
+#else
+#    define WHEEL_MAX INT8_MAX
+#endif
+
+// Fixed point gain, 16 = 1.0
+#define GAIN_ONE 16
+// Sending by time as well covers a bus without SOFs (suspend).
+#define FRAME_US 1000
+
+static int16_t  pending_detents = 0;
+static int32_t  residue         = 0;
+static uint16_t send_tmr        = 0;
+static uint16_t sent_frame;
+static uint32_t sent_at;
+
+void mouse_batch_wheel(int8_t detents) {
+    pending_detents += detents;
+}
+
+static int32_t gain_for(int16_t detents) {
+#ifdef MOUSE_BATCH_WHEEL_ACCEL
+    int32_t gain = GAIN_ONE + (int32_t)(abs(detents) - 1) * MOUSE_BATCH_WHEEL_ACCEL;
+    return MIN(gain, GAIN_ONE * MOUSE_BATCH_WHEEL_ACCEL_MAX);
+#else
+    (void)detents;
+    return GAIN_ONE;
+#endif
+}
+
+static bool wheel_due(void) {
+    if (pending_detents == 0 && residue / GAIN_ONE == 0) {
+        return false;
+    }
+    return timer_elapsed(send_tmr) >= MOUSE_BATCH_INTERVAL_MS;
+}
+
+// The wheel units for this report; the rest waits for the next interval.
+static int32_t take_wheel(void) {
+    residue += (int32_t)pending_detents * WHEEL_UNITS_PER_DETENT * gain_for(pending_detents);
+    pending_detents = 0;
+
+    // Whatever does not fit one report (or is a fraction of a unit) is
+    // carried into the next interval.
+    int32_t wheel = residue / GAIN_ONE;
+    wheel         = MAX(-WHEEL_MAX, MIN(WHEEL_MAX, wheel));
+    residue -= wheel * GAIN_ONE;
+    if (wheel != 0) {
+        send_tmr = timer_read();
+    }
+    return wheel;
+}
+
+void mouse_batch_task(void) {
+    bool wheel = wheel_due();
+#ifdef MOUSE_MOTION_ENABLE
+    bool motion = mouse_motion_active();
+#else
+    bool motion = false;
+#endif
+    if (!wheel && !motion) {
+        return;
+    }
+    uint32_t now   = TRACE_NOW();
+    uint16_t frame = usb_hw->sof_rd & USB_SOF_RD_BITS;
+    if (frame == sent_frame && now - sent_at < FRAME_US) {
+        return;
+    }
+
+    report_mouse_t report = mousekey_get_report();
+    report.x              = 0;
+    report.y              = 0;
+    report.h              = 0;
+    report.v              = 0;
+#ifdef MOUSE_MOTION_ENABLE
+    if (motion) {
+        mouse_motion_take(&report);
+    }
+#endif
+    if (wheel) {
+        report.v = take_wheel();
+    }
+    if (report.x == 0 && report.y == 0 && report.v == 0) {
+        return;
+    }
+    host_mouse_send(&report);
+    sent_frame = frame;
+    sent_at    = now;
+}
+
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdint.h>
+
+// Minimum time between two wheel reports. The first detent after a pause is
+// sent right away; detents arriving within the interval are summed.
+#ifndef MOUSE_BATCH_INTERVAL_MS
+#    define MOUSE_BATCH_INTERVAL_MS 8
+#endif
+
+// Velocity acceleration, off unless MOUSE_BATCH_WHEEL_ACCEL is defined (4 is
+// a good start): every detent beyond the first in one interval adds
+// MOUSE_BATCH_WHEEL_ACCEL/16 to the gain, up to MOUSE_BATCH_WHEEL_ACCEL_MAX.
+#ifndef MOUSE_BATCH_WHEEL_ACCEL_MAX
+#    define MOUSE_BATCH_WHEEL_ACCEL_MAX 4
+#endif
+
+// Queues wheel detents, positive scrolls up.
+void mouse_batch_wheel(int8_t detents);
+
+// Sends the mouse report: the summed wheel delta at most once per interval,
+// together with mouse_motion.c's movement, and at most one report per USB
+// frame.
+void mouse_batch_task(void);
@@ -0,0 +1,124 @@
+// Time-based mouse key movement (mouse_motion.h).
+//
+// QMK's mousekey_task() moves a fixed step whenever MOUSEKEY_INTERVAL has
+// passed since its last report and counts acceleration in reports, so a
+// loop that runs late (an LED frame, a flash write) stretches every
+// interval after it and the cursor ends up short. Here the distance is
+// worked out from the hold time alone, in 1/256 pixel, and a report only
+// hands over the part not sent yet.
+
+#include "quantum.h"
+#include "mouse_motion.h"
+#include "trace.h"
+
+#ifdef MOUSE_ENABLE
+
+_Static_assert(MOUSE_MOTION_SPEED_START <= MOUSE_MOTION_SPEED_MAX && MOUSE_MOTION_ACCEL_MS > 0, "MOUSE_MOTION_SPEED_START must not exceed MOUSE_MOTION_SPEED_MAX");
+
+#define RAMP_US ((uint64_t)MOUSE_MOTION_ACCEL_MS * 1000)
+// Residues are kept in 1/65536 pixel so the diagonal scale loses nothing.
+#define PIXEL 65536
+#define STRAIGHT 256
+// 1/sqrt(2) in 1/256
+#define DIAGONAL 181
+
+enum {
+    MOVE_UP    = 1 << 0,
+    MOVE_DOWN  = 1 << 1,
+    MOVE_LEFT  = 1 << 2,
+    MOVE_RIGHT = 1 << 3,
+};
+
+static uint8_t  held = 0;
+static uint32_t held_at;
+static uint64_t travelled;
+static int32_t  residue_x, residue_y;
+
+static uint8_t direction_of(uint16_t keycode) {
+    switch (keycode) {
+        case MS_UP:
+            return MOVE_UP;
+        case MS_DOWN:
+            return MOVE_DOWN;
+        case MS_LEFT:
+            return MOVE_LEFT;
+        case MS_RGHT:
+            return MOVE_RIGHT;
+        default:
+            return 0;
+    }
+}
+
+// 1/256 pixels covered after holding for us.
+static uint64_t distance(uint32_t us) {
+    uint64_t t = us, area;
+
+    if (t < RAMP_US) {
+        area = MOUSE_MOTION_SPEED_START * t + (MOUSE_MOTION_SPEED_MAX - MOUSE_MOTION_SPEED_START) * t * t / (2 * RAMP_US);
+    } else {
+        area = (MOUSE_MOTION_SPEED_START + MOUSE_MOTION_SPEED_MAX) * RAMP_US / 2 + MOUSE_MOTION_SPEED_MAX * (t - RAMP_US);
+    }
+    return area * 256 / 1000000;
+}
+
+// Moves the residues along the keys held until now, so a key change takes
+// effect at the time of the event rather than of the next report.
+static void advance(uint32_t now) {
+    uint64_t covered = distance(now - held_at);
+    // The timer wraps after ~71 minutes of holding; ramp up again from there.
+    int32_t step = covered > travelled ? (int32_t)(covered - travelled) : 0;
+    travelled    = covered;
+
+    int8_t dx = !!(held & MOVE_RIGHT) - !!(held & MOVE_LEFT);
+    int8_t dy = !!(held & MOVE_DOWN) - !!(held & MOVE_UP);
+    step *= dx && dy ? DIAGONAL : STRAIGHT;
+    residue_x += dx * step;
+    residue_y += dy * step;
+}
+
+static int8_t take(int32_t *residue) {
+    int32_t whole = *residue / PIXEL;
+
+    whole = MAX(-127, MIN(127, whole));
+    *residue -= whole * PIXEL;
+    return (int8_t)whole;
+}
+
+static bool pending(void) {
+    return residue_x <= -PIXEL || residue_x >= PIXEL || residue_y <= -PIXEL || residue_y >= PIXEL;
+}
+
+bool mouse_motion_process(uint16_t keycode, keyrecord_t *record) {
+    uint8_t direction = direction_of(keycode);
+
+    if (!direction) {
+        return true;
+    }
+    uint32_t now = TRACE_NOW();
+    if (held) {
+        advance(now);
+    } else {
+        held_at   = now;
+        travelled = 0;
+    }
+    if (record->event.pressed) {
+        held |= direction;
+    } else {
+        held &= (uint8_t)~direction;
+    }
+    return false;
+}
+
+void mouse_motion_take(report_mouse_t *report) {
+    if (held) {
+        advance(TRACE_NOW());
+    }
+    report->x = take(&residue_x);
+    report->y = take(&residue_y);
+}
+
+bool mouse_motion_active(void) {
+    return held || pending();
+}
+
+#endif
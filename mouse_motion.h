@@ -0,0 +1,37 @@
+#pragma once
+
+#include "quantum.h"
+
+// Cursor movement for MS_UP/MS_DOWN/MS_LEFT/MS_RGHT in place of QMK's
+// mousekey movement. The distance travelled is a function of how long the
+// keys have been held on the microsecond timer: the speed rises evenly from
+// MOUSE_MOTION_SPEED_START to MOUSE_MOTION_SPEED_MAX over
+// MOUSE_MOTION_ACCEL_MS and stays there. Each report carries all whole
+// pixels covered since the last one, so the path does not depend on the scan
+// rate, on late loops or on when reports go out. Diagonals move at the same
+// speed as straight lines. Buttons stay with mousekey; mouse_batch.c sends
+// the reports, with the wheel, at most one per USB frame.
+//
+// The defaults are close to QMK's mousekey defaults (MOVE_DELTA 8,
+// MAX_SPEED 10, TIME_TO_MAX 30, INTERVAL 20).
+
+// Pixels per second.
+#ifndef MOUSE_MOTION_SPEED_START
+#    define MOUSE_MOTION_SPEED_START 100
+#endif
+#ifndef MOUSE_MOTION_SPEED_MAX
+#    define MOUSE_MOTION_SPEED_MAX 4000
+#endif
+#ifndef MOUSE_MOTION_ACCEL_MS
+#    define MOUSE_MOTION_ACCEL_MS 600
+#endif
+
+// From process_record_kb(); takes the four movement keycodes.
+bool mouse_motion_process(uint16_t keycode, keyrecord_t *record);
+
+// From mouse_batch_task(), once per report: sets x and y to the whole pixels
+// covered since the last report.
+void mouse_motion_take(report_mouse_t *report);
+
+// A movement key is held or whole pixels are still to be sent.
+bool mouse_motion_active(void);
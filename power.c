@@ -0,0 +1,198 @@
+// Idle-aware scanning and sleep (power.h).
+//
+// Sleeping is a wait on a binary semaphore: ChibiOS runs its idle thread,
+// which executes WFI (CORTEX_ENABLE_WFI_IDLE in chconf.h), and an edge on a
+// row, the encoder or the encoder button signals the semaphore from its
+// interrupt. USB keeps running, so no host request is missed. RP2040
+// DORMANT is not used: it stops the USB controller, which has to see the
+// host resume the bus, and restarting the crystal and PLLs costs
+// milliseconds on every wake.
+//
+// While the host is being woken the USB driver is not configured and
+// ChibiOS drops every report, so the key that woke it would be lost. Such
+// key events are held here and replayed once USB is configured again. This
+// runs from process_record_kb(), which QMK always reaches, after tapping
+// and before any action.
+
+#include "quantum.h"
+#include "usb_main.h"
+#include "power.h"
+#include "trace.h"
+#include "hot_path.h"
+#ifdef RGB_STREAM_ENABLE
+#    include "rgb_stream.h"
+#endif
+#ifdef MOUSE_MOTION_ENABLE
+#    include "mouse_motion.h"
+#endif
+
+typedef struct {
+    uint64_t us;
+    uint64_t asleep_us;
+    uint32_t sleeps;
+    uint32_t edge_wakes;
+    uint32_t wake_us_last;
+    uint32_t wake_us_max;
+} power_account_t;
+
+static binary_semaphore_t wake;
+static bool               wake_ready = false;
+static uint8_t            state      = POWER_ACTIVE;
+static uint32_t           state_at   = 0;
+static power_account_t    account[POWER_STATES];
+
+// Set by the first edge while asleep, until its key is processed or the
+// next idle sleep starts.
+static volatile bool     edge_pending = false;
+static volatile uint32_t edge_at;
+static volatile uint8_t  edge_state;
+
+static keyrecord_t held[POWER_HOLD_EVENTS];
+static uint8_t     held_count = 0;
+static uint16_t    held_at;
+static bool        replaying = false;
+
+// Raw HID and VIA packets; QMK only counts matrix and encoder input.
+static uint32_t host_at = 0;
+
+void power_wake_isr(void *arg) {
+    (void)arg;
+    chSysLockFromISR();
+    if (!edge_pending) {
+        edge_pending = true;
+        edge_at      = TRACE_NOW();
+        edge_state   = state;
+    }
+    chBSemSignalI(&wake);
+    chSysUnlockFromISR();
+}
+
+static void enter(uint8_t next) {
+    uint32_t now = TRACE_NOW();
+
+    account[state].us += now - state_at;
+    state_at = now;
+    state    = next;
+}
+
+static void sleep_for(uint16_t ms) {
+    if (!wake_ready) {
+        chBSemObjectInit(&wake, true);
+        wake_ready = true;
+    }
+    chBSemReset(&wake, true);
+    if (matrix_wake_arm()) {
+        uint32_t start = TRACE_NOW();
+        msg_t    msg   = chBSemWaitTimeout(&wake, TIME_MS2I(ms));
+
+        account[state].asleep_us += TRACE_NOW() - start;
+        account[state].sleeps++;
+        account[state].edge_wakes += msg == MSG_OK;
+    }
+    matrix_wake_disarm();
+}
+
+static void woke_for(const keyrecord_t *record) {
+    if (!edge_pending || !record->event.pressed) {
+        return;
+    }
+    edge_pending          = false;
+    power_account_t *from = &account[edge_state];
+    from->wake_us_last    = TRACE_NOW() - edge_at;
+    from->wake_us_max     = MAX(from->wake_us_max, from->wake_us_last);
+}
+
+// Tapping has seen these already; process_record() runs them through
+// process_record_kb(), here again, and on to their actions.
+static void replay_held(void) {
+    replaying = true;
+    for (uint8_t i = 0; i < held_count; i++) {
+        process_record(&held[i]);
+    }
+    held_count = 0;
+    replaying  = false;
+}
+
+bool HOT_PATH(power_process)(keyrecord_t *record) {
+    if (replaying) {
+        woke_for(record);
+        return true;
+    }
+    if (held_count == 0 && USB_DRIVER.state == USB_ACTIVE) {
+        woke_for(record);
+        return true;
+    }
+    if (held_count == ARRAY_SIZE(held)) {
+        // Out of room: keep the order and let the rest go as they come.
+        replay_held();
+        return true;
+    }
+    if (held_count == 0) {
+        held_at = timer_read();
+    }
+    held[held_count++] = *record;
+    return false;
+}
+
+void power_activity(void) {
+    host_at = timer_read32();
+}
+
+static uint8_t idle_state(void) {
+    uint32_t idle = MIN(last_input_activity_elapsed(), timer_elapsed32(host_at));
+
+    if (idle >= POWER_SLEEP_MS) {
+        return POWER_SLEEP;
+    }
+    return idle >= POWER_IDLE_MS ? POWER_IDLE : POWER_ACTIVE;
+}
+
+void power_task(void) {
+    // After a timeout the replay still runs, so QMK's key state stays
+    // consistent even if the reports are lost.
+    if (held_count && (USB_DRIVER.state == USB_ACTIVE || timer_elapsed(held_at) >= POWER_HOLD_MS)) {
+        replay_held();
+    }
+
+    enter(idle_state());
+    if (state == POWER_ACTIVE || held_count) {
+        return;
+    }
+#ifdef RGB_STREAM_ENABLE
+    // Raw HID packets do not signal the wake semaphore; a sleep would hold
+    // the next frame back.
+    if (rgb_stream_active()) {
+        return;
+    }
+#endif
+#ifdef MOUSE_MOTION_ENABLE
+    // A held movement key is not input activity, but the cursor moves
+    // every frame.
+    if (mouse_motion_active()) {
+        return;
+    }
+#endif
+    edge_pending = false;
+    sleep_for(state == POWER_IDLE ? POWER_IDLE_SCAN_MS : POWER_SLEEP_SCAN_MS);
+}
+
+void power_suspend(void) {
+    // The first edge stays pending until its key is replayed after the
+    // host has woken up.
+    enter(POWER_SUSPEND);
+    sleep_for(POWER_SUSPEND_SLEEP_MS);
+}
+
+void power_stats(uint8_t state_index, power_stats_t *stats) {
+    enter(state);
+
+    const power_account_t *from = &account[state_index];
+    *stats = (power_stats_t){
+        .ms           = from->us / 1000,
+        .asleep_ms    = from->asleep_us / 1000,
+        .sleeps       = from->sleeps,
+        .edge_wakes   = from->edge_wakes,
+        .wake_us_last = from->wake_us_last,
+        .wake_us_max  = from->wake_us_max,
+    };
+}
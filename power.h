@@ -0,0 +1,88 @@
+#pragma once
+
+#include "quantum.h"
+
+// Idle power states. The main loop scans at full rate while keys or the
+// host are in use; once idle it sleeps between loops with every column
+// driven low, so the first press pulls its row low through the diode and
+// the edge wakes the loop at once. The
+// sleep period only paces housekeeping (LED frames, the RGB store), not the
+// key latency.
+
+// Input-free time before the loop starts sleeping, and the sleep per loop.
+#ifndef POWER_IDLE_MS
+#    define POWER_IDLE_MS 1000
+#endif
+#ifndef POWER_IDLE_SCAN_MS
+#    define POWER_IDLE_SCAN_MS 10
+#endif
+
+// Input-free time before the longer sleeps; by default when rgblight's
+// timeout turns the LEDs off.
+#ifndef POWER_SLEEP_MS
+#    ifdef RGBLIGHT_TIMEOUT
+#        define POWER_SLEEP_MS RGBLIGHT_TIMEOUT
+#    else
+#        define POWER_SLEEP_MS 600000
+#    endif
+#endif
+#ifndef POWER_SLEEP_SCAN_MS
+#    define POWER_SLEEP_SCAN_MS 100
+#endif
+
+// Sleep per pass of QMK's suspend loop, on top of its own wait_ms(17).
+#ifndef POWER_SUSPEND_SLEEP_MS
+#    define POWER_SUSPEND_SLEEP_MS 50
+#endif
+
+// Key events while USB is not configured (waking the host, enumerating)
+// are held back and replayed once it is, at the latest after this long.
+#ifndef POWER_HOLD_MS
+#    define POWER_HOLD_MS 1000
+#endif
+#ifndef POWER_HOLD_EVENTS
+#    define POWER_HOLD_EVENTS 8
+#endif
+
+enum power_state {
+    POWER_ACTIVE,
+    POWER_IDLE,
+    POWER_SLEEP,
+    POWER_SUSPEND,
+    POWER_STATES,
+};
+
+// Per state: time spent in it and asleep in it, sleeps and how many of them
+// an edge ended, and the time from a waking edge to its key being processed
+// (the report goes out in the same call).
+typedef struct {
+    uint32_t ms;
+    uint32_t asleep_ms;
+    uint32_t sleeps;
+    uint32_t edge_wakes;
+    uint32_t wake_us_last;
+    uint32_t wake_us_max;
+} power_stats_t;
+
+// From housekeeping_task_kb(). Picks the state and sleeps if idle.
+void power_task(void);
+
+// From suspend_power_down_kb(), which QMK calls in a loop while suspended.
+void power_suspend(void);
+
+// From process_record_kb(). Returns false for the events it holds back.
+bool power_process(keyrecord_t *record);
+
+// From host_cmd_receive(): a raw HID or VIA packet counts as activity, so
+// the loop does not sleep between the packets of a VIA session.
+void power_activity(void);
+
+// Edge callback for the wake pins.
+void power_wake_isr(void *arg);
+
+void power_stats(uint8_t state, power_stats_t *stats);
+
+// Implemented by the matrix: drives the columns low and arms edge wake-ups
+// on the rows and the encoder. Returns false if a row is already low.
+bool matrix_wake_arm(void);
+void matrix_wake_disarm(void);
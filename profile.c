@@ -0,0 +1,96 @@
+// Keymap profiles (profile.h).
+//
+// The image is checked once at boot; after that a switch is a pointer swap
+// in keymap_cache.c plus resolving the 28 keys again, a few microseconds.
+// The tables are read in place through XIP like the compiled-in keymap, and
+// once resolved a key press does not touch them.
+
+#include <string.h>
+#include "quantum.h"
+#include "profile.h"
+#include "keymap_cache.h"
+#include "hardware/regs/addressmap.h"
+
+#define IMAGE ((const uint8_t *)(XIP_BASE + PROFILE_FLASH_OFFSET))
+
+typedef const uint16_t profile_layer_t[MATRIX_ROWS][MATRIX_COLS];
+
+static uint8_t count   = 0;
+static uint8_t layers  = 0;
+static uint8_t current = 0;
+static size_t  stride;
+
+static const char keymap_name[PROFILE_NAME_LEN] = "keymap";
+
+static uint32_t crc32(const uint8_t *data, size_t length) {
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (length--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = crc >> 1 ^ (0xEDB88320 & -(crc & 1));
+        }
+    }
+    return ~crc;
+}
+
+static const uint8_t *entry(uint8_t index) {
+    return IMAGE + sizeof(profile_image_t) + (index - 1) * stride;
+}
+
+void profile_init(void) {
+    const profile_image_t *header = (const profile_image_t *)IMAGE;
+
+    count   = 0;
+    current = 0;
+    if (header->magic != PROFILE_MAGIC || header->version != PROFILE_VERSION || header->rows != MATRIX_ROWS || header->cols != MATRIX_COLS) {
+        return;
+    }
+    if (header->count == 0 || header->count >= PROFILE_MAX || header->layers == 0 || header->layers > MAX_LAYER) {
+        return;
+    }
+    stride = PROFILE_NAME_LEN + sizeof(profile_layer_t) * header->layers;
+    if (crc32(IMAGE + sizeof(profile_image_t), stride * header->count) != header->crc32) {
+        return;
+    }
+    count  = header->count;
+    layers = header->layers;
+}
+
+uint8_t profile_count(void) {
+    return count + 1;
+}
+
+uint8_t profile_current(void) {
+    return current;
+}
+
+const char *profile_name(uint8_t index) {
+    if (index == 0 || index > count) {
+        return keymap_name;
+    }
+    return (const char *)entry(index);
+}
+
+bool profile_select(uint8_t index) {
+    if (index > count) {
+        return false;
+    }
+    // Held keys and momentary layers would be released through the other
+    // profile's keycodes.
+    clear_keyboard();
+    layer_clear();
+    current = index;
+    keymap_cache_use(index ? (profile_layer_t *)(entry(index) + PROFILE_NAME_LEN) : NULL, layers);
+    return true;
+}
+
+bool profile_process(uint16_t keycode, keyrecord_t *record) {
+    if (keycode != PF_NEXT) {
+        return true;
+    }
+    if (record->event.pressed) {
+        profile_select((current + 1) % profile_count());
+    }
+    return false;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "quantum.h"
+
+// Keymap profiles: complete sets of layers stored read-only in flash,
+// packed by tools/profiles.py into an image of
+//   profile_image_t, then per profile a PROFILE_NAME_LEN name and
+//   layers x MATRIX_ROWS x MATRIX_COLS keycodes (uint16_t, LE)
+// at PROFILE_FLASH_OFFSET. Profile 0 is the firmware's own keymap (the VIA
+// one with a dynamic keymap); the image adds profiles 1 and up. Switching
+// swaps the table keymap lookups read from; nothing is written to EEPROM,
+// and every boot starts on profile 0.
+
+// Well past the firmware and clear of the wear-leveling area at the end of
+// flash. tools/profiles.py --offset must match.
+#ifndef PROFILE_FLASH_OFFSET
+#    define PROFILE_FLASH_OFFSET 0x100000
+#endif
+
+#ifndef PROFILE_MAX
+#    define PROFILE_MAX 16
+#endif
+
+// Defined in every build so keymaps can place it; does nothing without
+// PROFILES_ENABLE.
+enum profile_keycodes {
+    PF_NEXT = QK_KB_0,
+};
+
+#define PROFILE_MAGIC 0x4650524B // "KRPF"
+#define PROFILE_VERSION 1
+#define PROFILE_NAME_LEN 16
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint8_t  count;
+    uint8_t  layers;
+    uint8_t  rows;
+    uint8_t  cols;
+    uint16_t reserved;
+    uint32_t crc32; // of everything after the header
+} profile_image_t;
+
+// Checks the image in flash. Call before keymap_cache_init().
+void profile_init(void);
+
+// Profiles including the firmware's own keymap.
+uint8_t profile_count(void);
+uint8_t profile_current(void);
+// PROFILE_NAME_LEN bytes, not necessarily NUL-terminated.
+const char *profile_name(uint8_t index);
+
+// Releases every key, turns off every layer but the default one and
+// switches. Returns false for an index past profile_count().
+bool profile_select(uint8_t index);
+
+// PF_NEXT: the next profile, wrapping to the keymap's own.
+bool profile_process(uint16_t keycode, keyrecord_t *record);
@@ -0,0 +1,32 @@
+#pragma once
+
+// Quadrature decoder PIO program, assembled by hand (the QMK build has no
+// pioasm step). The state machine keeps the signed transition count in Y and
+// pushes it on every loop, so no edge is lost however late the CPU reads it.
+//
+// The program must be loaded at offset 0: the first 16 instructions form a
+// jump table indexed by (previous AB << 2) | current AB, with the same
+// state encoding and direction as QMK's software decoder.
+//
+//  0-13  jmp update/decrement/increment   ; jump table
+//  14    decrement: jmp y--, update       ; also table entry 14
+//  15    update:    mov isr, y            ; table entry 15, wrap target
+//  16               push noblock
+//  17               out isr, 2            ; previous AB from OSR
+//  18               in pins, 2            ; current AB
+//  19               mov osr, isr
+//  20               mov pc, isr
+//  21    increment: mov y, ~y
+//  22               jmp y--, 23
+//  23               mov y, ~y             ; wrap
+
+#include <stdint.h>
+
+#define quadrature_encoder_wrap_target 15
+#define quadrature_encoder_wrap 23
+
+static const uint16_t quadrature_encoder_program_instructions[] = {
+    0x000f, 0x000e, 0x0015, 0x000f, 0x0015, 0x000f, 0x000f, 0x000e,
+    0x000e, 0x000f, 0x000f, 0x0015, 0x000f, 0x0015, 0x008f, 0xa0c2,
+    0x8000, 0x60c2, 0x4002, 0xa0e6, 0xa0a6, 0xa04a, 0x0097, 0xa04a,
+};
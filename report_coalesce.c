@@ -0,0 +1,185 @@
+// Report coalescing (report_coalesce.h).
+//
+// QMK sends a report for every key event, so keys changing in the same scan
+// go out as several reports, and on ChibiOS each one after the first waits
+// for the next USB poll with the main loop stopped. Here the host driver's
+// keyboard and NKRO callbacks only update the newest queued report; the
+// main loop sends one per frame.
+//
+// A newer report may replace the newest queued one unless it undoes a
+// change that one makes to what the host will have seen before it; then it
+// is queued behind it.
+
+#include <string.h>
+#include "quantum.h"
+#include "report_coalesce.h"
+#include "trace.h"
+#include "hot_path.h"
+#include "hardware/structs/usb.h"
+
+_Static_assert(REPORT_COALESCE_QUEUE <= 128 && (REPORT_COALESCE_QUEUE & (REPORT_COALESCE_QUEUE - 1)) == 0, "REPORT_COALESCE_QUEUE must be a power of two up to 128");
+
+// Flushing by time as well covers a bus without SOFs (suspend).
+#define FRAME_US 1000
+
+typedef struct {
+    bool nkro;
+    union {
+        report_keyboard_t keyboard;
+        report_nkro_t     nkro;
+    } report;
+} queued_t;
+
+static host_driver_t           coalesce_driver;
+static host_driver_t          *inner_driver = NULL;
+static report_coalesce_stats_t stats;
+static uint16_t                sent_frame;
+static uint32_t                sent_at;
+
+static queued_t queue[REPORT_COALESCE_QUEUE];
+static uint8_t  head = 0;
+static uint8_t  tail = 0;
+// The newest entry still takes in new reports.
+static bool open = false;
+
+// What the host has once every entry before the newest has been sent.
+static report_keyboard_t keyboard_base;
+static report_nkro_t     nkro_base;
+
+static uint8_t queued(void) {
+    return (uint8_t)(head - tail);
+}
+
+static queued_t *newest(void) {
+    return &queue[(uint8_t)(head - 1) & (REPORT_COALESCE_QUEUE - 1)];
+}
+
+static bool has_key(const report_keyboard_t *report, uint8_t key) {
+    for (uint8_t i = 0; i < ARRAY_SIZE(report->keys); i++) {
+        if (report->keys[i] == key) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// True if next takes back a key or modifier change of open against base.
+static bool undoes_keyboard(const report_keyboard_t *open_report, const report_keyboard_t *next) {
+    if ((open_report->mods ^ keyboard_base.mods) & (next->mods ^ open_report->mods)) {
+        return true;
+    }
+    for (uint8_t i = 0; i < ARRAY_SIZE(open_report->keys); i++) {
+        uint8_t key = open_report->keys[i];
+        if (key && !has_key(&keyboard_base, key) && !has_key(next, key)) {
+            return true;
+        }
+        key = keyboard_base.keys[i];
+        if (key && !has_key(open_report, key) && has_key(next, key)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool undoes_nkro(const report_nkro_t *open_report, const report_nkro_t *next) {
+    if ((open_report->mods ^ nkro_base.mods) & (next->mods ^ open_report->mods)) {
+        return true;
+    }
+    for (uint8_t i = 0; i < ARRAY_SIZE(open_report->bits); i++) {
+        if ((open_report->bits[i] ^ nkro_base.bits[i]) & (next->bits[i] ^ open_report->bits[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The newest entry stops taking reports; later ones build on it.
+static void close_newest(void) {
+    queued_t *entry = newest();
+
+    if (entry->nkro) {
+        nkro_base = entry->report.nkro;
+    } else {
+        keyboard_base = entry->report.keyboard;
+    }
+    open = false;
+}
+
+static void send_oldest(void) {
+    queued_t *entry = &queue[tail & (REPORT_COALESCE_QUEUE - 1)];
+
+    if (queued() == 1 && open) {
+        close_newest();
+    }
+    tail++;
+    if (entry->nkro) {
+        inner_driver->send_nkro(&entry->report.nkro);
+    } else {
+        inner_driver->send_keyboard(&entry->report.keyboard);
+    }
+    stats.reports_out++;
+    sent_frame = usb_hw->sof_rd & USB_SOF_RD_BITS;
+    sent_at    = TRACE_NOW();
+}
+
+static queued_t *append(void) {
+    if (open) {
+        close_newest();
+        stats.kept_apart++;
+    }
+    if (queued() == REPORT_COALESCE_QUEUE) {
+        send_oldest();
+    }
+    open = true;
+    return &queue[head++ & (REPORT_COALESCE_QUEUE - 1)];
+}
+
+static void HOT_PATH(coalesce_keyboard)(report_keyboard_t *report) {
+    queued_t *entry = newest();
+
+    stats.reports_in++;
+    if (!open || entry->nkro || undoes_keyboard(&entry->report.keyboard, report)) {
+        entry       = append();
+        entry->nkro = false;
+    }
+    entry->report.keyboard = *report;
+}
+
+static void HOT_PATH(coalesce_nkro)(report_nkro_t *report) {
+    queued_t *entry = newest();
+
+    stats.reports_in++;
+    if (!open || !entry->nkro || undoes_nkro(&entry->report.nkro, report)) {
+        entry       = append();
+        entry->nkro = true;
+    }
+    entry->report.nkro = *report;
+}
+
+void report_coalesce_task(void) {
+    host_driver_t *driver = host_get_driver();
+
+    if (driver != NULL && driver != &coalesce_driver) {
+        inner_driver                  = driver;
+        coalesce_driver               = *driver;
+        coalesce_driver.send_keyboard = coalesce_keyboard;
+        coalesce_driver.send_nkro     = coalesce_nkro;
+        host_set_driver(&coalesce_driver);
+        head = tail = 0;
+        open        = false;
+        memset(&keyboard_base, 0, sizeof(keyboard_base));
+        memset(&nkro_base, 0, sizeof(nkro_base));
+        return;
+    }
+    if (queued() == 0) {
+        return;
+    }
+    if ((usb_hw->sof_rd & USB_SOF_RD_BITS) == sent_frame && TRACE_NOW() - sent_at < FRAME_US) {
+        return;
+    }
+    send_oldest();
+}
+
+const report_coalesce_stats_t *report_coalesce_stats(void) {
+    return &stats;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+// Keyboard and NKRO reports are collected until the end of the main loop
+// and sent at most one per USB frame, instead of one per key event. A
+// report that would undo a change not yet sent (a key pressed and released
+// in the same scan, a modifier tapped by a macro) starts a new report
+// behind the first one, so no press or release is lost and presses go out
+// before the releases that follow them.
+
+// Reports waiting for their frame; when full the oldest is sent at once.
+#ifndef REPORT_COALESCE_QUEUE
+#    define REPORT_COALESCE_QUEUE 8
+#endif
+
+typedef struct {
+    uint32_t reports_in;  // reports QMK asked to send
+    uint32_t reports_out; // reports handed to USB
+    uint32_t kept_apart;  // of those, queued separately to keep a change
+} report_coalesce_stats_t;
+
+// From housekeeping_task_kb(), after everything else that sends reports.
+// Installs the hook on the host driver and sends the oldest waiting report
+// once the USB frame of the last one has passed.
+void report_coalesce_task(void);
+
+const report_coalesce_stats_t *report_coalesce_stats(void);
@@ -0,0 +1,191 @@
+// WS2812 rendering on the otherwise idle second core.
+//
+// Core 0 keeps rgblight disabled and hands on/mode/HSV to core 1 through one
+// packed mailbox word (rgb_core1_post). Core 1 renders static and breathing
+// frames itself and feeds a PIO state machine, so neither effect maths nor
+// the ~300 us frame push ever runs between two matrix scans.
+//
+// Core 1 only runs code and data from SRAM: the wear-leveling driver turns
+// XIP off while it erases or programs flash on core 0. Nothing here divides,
+// so no libgcc helper from flash is pulled in either.
+
+#include "quantum.h"
+#include "rgb_core1.h"
+#include "ws2812.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/sio.h"
+#include "hardware/structs/timer.h"
+#include "ws2812.pio.h"
+#include "hot_path.h"
+
+#define MAILBOX_ON (1u << 31)
+#define MAILBOX_MODE(word) (((word) >> 24) & 0x7F)
+#define MAILBOX_HUE(word) (((word) >> 16) & 0xFF)
+#define MAILBOX_SAT(word) (((word) >> 8) & 0xFF)
+#define MAILBOX_VAL(word) ((word)&0xFF)
+
+// Reset time plus the last word still shifting out of the OSR.
+#define RGB_CORE1_LATCH_US 320
+
+static const pio_program_t ws2812_program = {
+    .instructions = ws2812_program_instructions,
+    .length       = ARRAY_SIZE(ws2812_program_instructions),
+    .origin       = -1,
+};
+
+static volatile uint32_t mailbox = 0;
+static PIO               pio     = RGB_CORE1_PIO;
+static int               state_machine;
+static uint32_t          core1_stack[256];
+
+static void __not_in_flash_func(put_pixel)(uint32_t grb) {
+    while (pio->fstat & (1u << (PIO_FSTAT_TXFULL_LSB + state_machine))) {
+    }
+    pio->txf[state_machine] = grb << 8;
+}
+
+static uint32_t __not_in_flash_func(hsv_to_grb)(uint8_t hue, uint8_t sat, uint8_t val) {
+    uint32_t h6  = hue * 6u;
+    uint32_t rem = h6 & 0xFF;
+    uint32_t p   = val * (255u - sat) >> 8;
+    uint32_t q   = val * (255u - (sat * rem >> 8)) >> 8;
+    uint32_t t   = val * (255u - (sat * (255u - rem) >> 8)) >> 8;
+    uint32_t r, g, b;
+
+    // An if chain rather than a switch: thumb1 case tables call a libgcc
+    // helper that lives in flash.
+    uint32_t region = h6 >> 8;
+    if (region == 0) {
+        r = val, g = t, b = p;
+    } else if (region == 1) {
+        r = q, g = val, b = p;
+    } else if (region == 2) {
+        r = p, g = val, b = t;
+    } else if (region == 3) {
+        r = p, g = q, b = val;
+    } else if (region == 4) {
+        r = t, g = p, b = val;
+    } else {
+        r = val, g = p, b = q;
+    }
+    return g << 16 | r << 8 | b;
+}
+
+// Triangle wave squared, ~2.1 s per breath.
+static uint8_t __not_in_flash_func(breathe)(uint8_t val, uint32_t now) {
+    uint32_t phase = (now >> 12) & 0x1FF;
+    uint32_t tri   = phase & 0x100 ? 0x1FF - phase : phase;
+    return val * (tri * tri >> 8) >> 8;
+}
+
+static void __not_in_flash_func(core1_main)(void) {
+    uint32_t shown    = ~mailbox;
+    uint32_t frame_at = timer_hw->timerawl;
+
+    while (true) {
+        uint32_t state    = mailbox;
+        uint32_t now      = timer_hw->timerawl;
+        bool     animated = (state & MAILBOX_ON) && MAILBOX_MODE(state) >= RGBLIGHT_MODE_BREATHING && MAILBOX_MODE(state) < RGBLIGHT_MODE_BREATHING + 4;
+
+        if (state == shown && !(animated && now - frame_at >= RGB_CORE1_FRAME_US)) {
+            // Static: sleep until core 0 posts (rgb_core1_post sends an event).
+            if (!animated) {
+                __WFE();
+            }
+            continue;
+        }
+        shown    = state;
+        frame_at = now;
+
+        uint32_t val   = MIN(MAILBOX_VAL(state), RGBLIGHT_LIMIT_VAL);
+        uint32_t pixel = 0;
+        if (state & MAILBOX_ON) {
+            pixel = hsv_to_grb(MAILBOX_HUE(state), MAILBOX_SAT(state), animated ? breathe(val, now) : val);
+        }
+        for (uint8_t i = 0; i < RGBLIGHT_LED_COUNT; i++) {
+            put_pixel(pixel);
+        }
+
+        // Hold the line low long enough to latch before the next frame.
+        while (!(pio->fstat & (1u << (PIO_FSTAT_TXEMPTY_LSB + state_machine)))) {
+        }
+        for (uint32_t start = timer_hw->timerawl; timer_hw->timerawl - start < RGB_CORE1_LATCH_US;) {
+        }
+    }
+}
+
+static void fifo_push(uint32_t value) {
+    while (!(sio_hw->fifo_st & SIO_FIFO_ST_RDY_BITS)) {
+    }
+    sio_hw->fifo_wr = value;
+    __SEV();
+}
+
+static uint32_t fifo_pop(void) {
+    while (!(sio_hw->fifo_st & SIO_FIFO_ST_VLD_BITS)) {
+        __WFE();
+    }
+    return sio_hw->fifo_rd;
+}
+
+// Boot ROM handshake that releases core 1 (RP2040 datasheet 2.8.2): every
+// word has to be echoed back, a mismatch restarts the sequence.
+static void launch_core1(void (*entry)(void)) {
+    const uint32_t sequence[] = {0, 0, 1, SCB->VTOR, (uint32_t)&core1_stack[ARRAY_SIZE(core1_stack)], (uint32_t)entry};
+    uint8_t        i          = 0;
+
+    while (i < ARRAY_SIZE(sequence)) {
+        if (sequence[i] == 0) {
+            while (sio_hw->fifo_st & SIO_FIFO_ST_VLD_BITS) {
+                (void)sio_hw->fifo_rd;
+            }
+            __SEV();
+        }
+        fifo_push(sequence[i]);
+        i = fifo_pop() == sequence[i] ? i + 1 : 0;
+    }
+}
+
+void rgb_core1_init(void) {
+    state_machine   = pio_claim_unused_sm(pio, true);
+    uint32_t offset = pio_add_program(pio, &ws2812_program);
+
+    pio_gpio_init(pio, WS2812_DI_PIN);
+    pio_sm_set_consecutive_pindirs(pio, state_machine, WS2812_DI_PIN, 1, true);
+
+    pio_sm_config config = pio_get_default_sm_config();
+    sm_config_set_wrap(&config, offset + ws2812_wrap_target, offset + ws2812_wrap);
+    sm_config_set_sideset(&config, 1, false, false);
+    sm_config_set_sideset_pins(&config, WS2812_DI_PIN);
+    sm_config_set_out_shift(&config, false, true, 24);
+    sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&config, (float)clock_get_hz(clk_sys) / (800000 * ws2812_cycles_per_bit));
+    pio_sm_init(pio, state_machine, offset, &config);
+    pio_sm_set_enabled(pio, state_machine, true);
+
+    launch_core1(core1_main);
+}
+
+void rgb_core1_post(bool on, uint8_t mode, uint8_t hue, uint8_t sat, uint8_t val) {
+    mailbox = (on ? MAILBOX_ON : 0) | (uint32_t)(mode & 0x7F) << 24 | (uint32_t)hue << 16 | (uint32_t)sat << 8 | val;
+    __SEV();
+}
+
+// rgblight stays disabled on core 0; whatever it still emits goes nowhere.
+void ws2812_init(void) {}
+
+void ws2812_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
+    (void)index;
+    (void)red;
+    (void)green;
+    (void)blue;
+}
+
+void ws2812_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
+    (void)red;
+    (void)green;
+    (void)blue;
+}
+
+void ws2812_flush(void) {}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Frame period of animated modes on core 1. Static colours are only pushed
+// when they change.
+#ifndef RGB_CORE1_FRAME_US
+#    define RGB_CORE1_FRAME_US 16384
+#endif
+
+// PIO block for the WS2812 state machine; the matrix and encoder use pio1.
+#ifndef RGB_CORE1_PIO
+#    define RGB_CORE1_PIO pio0
+#endif
+
+// Claims the WS2812 state machine and starts the renderer on core 1.
+void rgb_core1_init(void);
+
+// Publishes the wanted LED state to core 1. A single word store: never
+// blocks, and the newest state simply replaces one core 1 has not seen yet.
+void rgb_core1_post(bool on, uint8_t mode, uint8_t hue, uint8_t sat, uint8_t val);
@@ -0,0 +1,240 @@
+// Per-layer RGB effects.
+//
+// The layer table is generated at compile time from rgb_layers.def. Effects
+// render straight into WS2812 colours with 8-bit fixed-point maths: sine and
+// breathing curves come from lookup tables, the HSV conversion uses shifts
+// and byte multiplies only, and every effect does a fixed amount of work per
+// LED, so a frame's cost does not depend on the state it shows.
+//
+// In RGB_EFFECT_MODE_LAYER rgb_state.c disables rgblight and hands the strip
+// to the engine, which writes frames through the ws2812 driver itself.
+
+#include "quantum.h"
+#include "rgb_effect.h"
+#include "trace.h"
+#ifdef RGB_EFFECT_ENABLE
+#    include "rgb_state.h"
+#    include "ws2812.h"
+#endif
+
+typedef struct {
+    uint8_t hue;
+    uint8_t effect;
+    uint8_t speed;
+    uint8_t spread;
+} rgb_layer_t;
+
+static const rgb_layer_t rgb_layers[] = {
+#define RGB_LAYER(layer, hue, effect, speed, spread) [layer] = {hue, RGB_EFFECT_##effect, speed, spread},
+#include "rgb_layers.def"
+#undef RGB_LAYER
+};
+
+static const rgb_layer_t *layer_entry(uint8_t layer) {
+    return &rgb_layers[layer < ARRAY_SIZE(rgb_layers) ? layer : 0];
+}
+
+uint8_t rgb_layer_hue(uint8_t layer) {
+    return layer_entry(layer)->hue;
+}
+
+bool rgb_effect_animated(uint8_t layer) {
+    return layer_entry(layer)->effect != RGB_EFFECT_STATIC;
+}
+
+// 127 * sin(2 pi i / 256) for the first quarter wave, peak included.
+static const uint8_t sine_quarter[65] = {
+    0,   3,   6,   9,   12,  16,  19,  22,  25,  28,  31,  34,  37,  40,  43,  46,  49,  51,  54,  57,  60,  63,
+    65,  68,  71,  73,  76,  78,  81,  83,  85,  88,  90,  92,  94,  96,  98,  100, 102, 104, 106, 107, 109, 111,
+    112, 113, 115, 116, 117, 118, 120, 121, 122, 122, 123, 124, 125, 125, 126, 126, 126, 127, 127, 127, 127,
+};
+
+// 255 * ((1 - cos(pi i / 63)) / 2)^2: half a breath, dark to full.
+static const uint8_t breathe_half[64] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   2,   3,   3,   5,   6,   7,   9,   11,  13,  16,
+    19,  22,  26,  30,  34,  39,  44,  49,  55,  61,  67,  74,  81,  88,  95,  103, 111, 119, 127, 135, 143, 152,
+    160, 168, 176, 184, 191, 199, 206, 213, 219, 225, 230, 235, 240, 244, 247, 250, 252, 254, 255, 255,
+};
+
+// 128 + 127 * sin(2 pi x / 256)
+static uint8_t sin8(uint8_t x) {
+    uint8_t i = x & 0x3F;
+
+    if (x < 64) {
+        return 128 + sine_quarter[i];
+    } else if (x < 128) {
+        return 128 + sine_quarter[64 - i];
+    } else if (x < 192) {
+        return 128 - sine_quarter[i];
+    }
+    return 128 - sine_quarter[64 - i];
+}
+
+static uint8_t breathe8(uint8_t x) {
+    return breathe_half[(x < 128 ? x : 255 - x) >> 1];
+}
+
+static uint8_t scale8(uint8_t value, uint8_t scale) {
+    return (value * (scale + 1)) >> 8;
+}
+
+static rgb_effect_led_t hsv_to_led(uint8_t hue, uint8_t sat, uint8_t val) {
+    uint32_t h6  = hue * 6u;
+    uint32_t rem = h6 & 0xFF;
+    uint8_t  p   = val * (255u - sat) >> 8;
+    uint8_t  q   = val * (255u - (sat * rem >> 8)) >> 8;
+    uint8_t  t   = val * (255u - (sat * (255u - rem) >> 8)) >> 8;
+
+    switch (h6 >> 8) {
+        case 0:
+            return (rgb_effect_led_t){val, t, p};
+        case 1:
+            return (rgb_effect_led_t){q, val, p};
+        case 2:
+            return (rgb_effect_led_t){p, val, t};
+        case 3:
+            return (rgb_effect_led_t){p, q, val};
+        case 4:
+            return (rgb_effect_led_t){t, p, val};
+        default:
+            return (rgb_effect_led_t){val, p, q};
+    }
+}
+
+typedef struct {
+    uint8_t hue;
+    uint8_t sat;
+    uint8_t val;
+    uint8_t phase;
+    uint8_t spread;
+    uint8_t count;
+} effect_args_t;
+
+static void render_static(const effect_args_t *args, rgb_effect_led_t *leds) {
+    rgb_effect_led_t led = hsv_to_led(args->hue, args->sat, args->val);
+    for (uint8_t i = 0; i < args->count; i++) {
+        leds[i] = led;
+    }
+}
+
+static void render_breathe(const effect_args_t *args, rgb_effect_led_t *leds) {
+    rgb_effect_led_t led = hsv_to_led(args->hue, args->sat, scale8(args->val, breathe8(args->phase)));
+    for (uint8_t i = 0; i < args->count; i++) {
+        leds[i] = led;
+    }
+}
+
+// Brightness wave running along the strip.
+static void render_wave(const effect_args_t *args, rgb_effect_led_t *leds) {
+    uint8_t angle = args->phase;
+    for (uint8_t i = 0; i < args->count; i++) {
+        leds[i] = hsv_to_led(args->hue, args->sat, scale8(args->val, sin8(angle)));
+        angle -= args->spread;
+    }
+}
+
+// Hue wheel starting at the layer hue.
+static void render_rainbow(const effect_args_t *args, rgb_effect_led_t *leds) {
+    uint8_t hue = args->hue + args->phase;
+    for (uint8_t i = 0; i < args->count; i++) {
+        leds[i] = hsv_to_led(hue, args->sat, args->val);
+        hue += args->spread;
+    }
+}
+
+// One bright LED going round, each one behind it at a quarter of the last.
+static void render_chase(const effect_args_t *args, rgb_effect_led_t *leds) {
+    int16_t head = (args->phase * args->count) >> 8;
+    for (uint8_t i = 0; i < args->count; i++) {
+        int16_t behind = head - i;
+        if (behind < 0) {
+            behind += args->count;
+        }
+        leds[i] = hsv_to_led(args->hue, args->sat, behind < 4 ? args->val >> (behind * 2) : 0);
+    }
+}
+
+static void (*const renderers[RGB_EFFECT_COUNT])(const effect_args_t *, rgb_effect_led_t *) = {
+    [RGB_EFFECT_STATIC] = render_static, [RGB_EFFECT_BREATHE] = render_breathe, [RGB_EFFECT_WAVE] = render_wave, [RGB_EFFECT_RAINBOW] = render_rainbow, [RGB_EFFECT_CHASE] = render_chase,
+};
+
+void rgb_effect_render(uint8_t layer, uint8_t hue, uint8_t sat, uint8_t val, uint32_t now_ms, rgb_effect_led_t *leds, uint8_t count) {
+    const rgb_layer_t *entry = layer_entry(layer);
+    effect_args_t      args  = {
+        .hue    = hue,
+        .sat    = sat,
+        .val    = MIN(val, RGBLIGHT_LIMIT_VAL),
+        .phase  = (now_ms >> 4) * entry->speed,
+        .spread = entry->spread,
+        .count  = count,
+    };
+
+    renderers[entry->effect](&args, leds);
+}
+
+#ifdef RGB_EFFECT_ENABLE
+
+static bool     active = false;
+static bool     dirty  = false;
+static bool     on     = false;
+static uint8_t  hue, sat, val;
+static uint8_t  shown_layer;
+static uint32_t frame_tmr;
+
+void rgb_effect_show(bool show, uint8_t new_hue, uint8_t new_sat, uint8_t new_val) {
+    dirty |= !active || show != on || new_hue != hue || new_sat != sat || new_val != val;
+    active = true;
+    on     = show;
+    hue    = new_hue;
+    sat    = new_sat;
+    val    = new_val;
+}
+
+void rgb_effect_stop(void) {
+    active = false;
+}
+
+static void push_frame(uint8_t layer) {
+    rgb_effect_led_t leds[RGBLIGHT_LED_COUNT] = {0};
+#    ifdef LATENCY_TRACE_ENABLE
+    uint32_t start = TRACE_NOW();
+#    endif
+    if (on) {
+        rgb_effect_render(layer, hue, sat, val, timer_read32(), leds, RGBLIGHT_LED_COUNT);
+    }
+    for (uint8_t i = 0; i < RGBLIGHT_LED_COUNT; i++) {
+        ws2812_set_color(i, leds[i].r, leds[i].g, leds[i].b);
+    }
+#    ifdef LATENCY_TRACE_ENABLE
+    TRACE(TRACE_RGB_FRAME, TRACE_NOW() - start);
+#    endif
+    ws2812_flush();
+    TRACE(TRACE_RGB_APPLY, hue);
+
+    frame_tmr   = timer_read32();
+    shown_layer = layer;
+    dirty       = false;
+}
+
+// Changes are coalesced like rgb_state.c does for rgblight.
+void rgb_effect_task(void) {
+    if (!active) {
+        return;
+    }
+
+    uint8_t  layer   = get_highest_layer(layer_state | default_layer_state);
+    uint32_t elapsed = timer_elapsed32(frame_tmr);
+    bool     changed = dirty || layer != shown_layer;
+    bool     due     = on && rgb_effect_animated(layer) && elapsed >= RGB_EFFECT_FRAME_MS;
+    if (due || (changed && elapsed >= RGB_STATE_REFRESH_MS)) {
+        push_frame(layer);
+    }
+}
+
+void rgb_effect_flush(void) {
+    if (active) {
+        push_frame(get_highest_layer(layer_state | default_layer_state));
+    }
+}
+
+#endif
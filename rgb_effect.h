@@ -0,0 +1,55 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Table-driven per-layer RGB effects (rgb_layers.def), rendered with 8-bit
+// fixed-point maths and sine/breathing lookup tables.
+
+// Frame period of animated effects.
+#ifndef RGB_EFFECT_FRAME_MS
+#    define RGB_EFFECT_FRAME_MS 20
+#endif
+
+// rgb_state_request() mode that hands the strip to the effect engine. Not an
+// rgblight mode.
+#define RGB_EFFECT_MODE_LAYER 0x70
+
+enum rgb_effect {
+    RGB_EFFECT_STATIC,
+    RGB_EFFECT_BREATHE,
+    RGB_EFFECT_WAVE,
+    RGB_EFFECT_RAINBOW,
+    RGB_EFFECT_CHASE,
+    RGB_EFFECT_COUNT,
+};
+
+typedef struct {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+} rgb_effect_led_t;
+
+// Base hue of a layer from rgb_layers.def.
+uint8_t rgb_layer_hue(uint8_t layer);
+
+// Whether the layer's effect changes over time.
+bool rgb_effect_animated(uint8_t layer);
+
+// Renders one frame of the layer's effect at time now_ms. Brightness is
+// capped at RGBLIGHT_LIMIT_VAL. Integer only, constant work per LED.
+void rgb_effect_render(uint8_t layer, uint8_t hue, uint8_t sat, uint8_t val, uint32_t now_ms, rgb_effect_led_t *leds, uint8_t count);
+
+// The engine owns the strip from the first rgb_effect_show() until
+// rgb_effect_stop(); rgblight must be disabled meanwhile. on=false blanks
+// the strip.
+void rgb_effect_show(bool on, uint8_t hue, uint8_t sat, uint8_t val);
+void rgb_effect_stop(void);
+
+// Pushes a frame when the state or the top layer changed, or when an
+// animation is due.
+void rgb_effect_task(void);
+
+// Pushes the current state right away, e.g. before the main loop stops for
+// a USB suspend.
+void rgb_effect_flush(void);
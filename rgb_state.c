@@ -0,0 +1,193 @@
+#include "quantum.h"
+#include "rgb_state.h"
+#include "trace.h"
+#ifdef RGB_CORE1_ENABLE
+#    include "rgb_core1.h"
+#endif
+#ifdef RGB_EFFECT_ENABLE
+#    include "rgb_effect.h"
+#endif
+
+#ifdef RGBLIGHT_ENABLE
+
+typedef struct {
+    bool    on;
+    uint8_t mode;
+    uint8_t hue;
+    uint8_t sat;
+    uint8_t val;
+} rgb_state_t;
+
+static rgb_state_t wanted;
+
+#if defined(RGB_CORE1_ENABLE) || defined(RGB_EFFECT_ENABLE)
+// With rgblight disabled these renderers handle the idle timeout and
+// suspend themselves.
+
+static bool suspended = false;
+
+static bool effective_on(void) {
+#    ifdef RGBLIGHT_TIMEOUT
+    if (last_input_activity_elapsed() >= RGBLIGHT_TIMEOUT) {
+        return false;
+    }
+#    endif
+    return wanted.on && !suspended;
+}
+#endif
+
+#ifdef RGB_CORE1_ENABLE
+
+// Core 1 renders (rgb_core1.c). Posting is a single store, so requests go
+// out right away.
+
+static bool shown_on = false;
+
+static void post(void) {
+    shown_on = effective_on();
+    rgb_core1_post(shown_on, wanted.mode, wanted.hue, wanted.sat, wanted.val);
+    TRACE(TRACE_RGB_APPLY, wanted.hue);
+}
+
+void rgb_state_request(bool on, uint8_t mode, uint8_t hue, uint8_t sat, uint8_t val) {
+    wanted.on   = on;
+    wanted.mode = mode;
+    wanted.hue  = hue;
+    wanted.sat  = sat;
+    wanted.val  = val;
+    TRACE(TRACE_RGB_REQUEST, hue);
+    post();
+}
+
+// QMK calls this on every pass of its suspend loop; only the change counts.
+void rgb_state_suspend(bool suspend) {
+    if (suspend == suspended) {
+        return;
+    }
+    suspended = suspend;
+    post();
+}
+
+void rgb_state_task(void) {
+    if (effective_on() != shown_on) {
+        post();
+    }
+}
+
+#else
+
+static rgb_state_t applied;
+static bool        applied_valid = false;
+static bool        dirty         = false;
+static uint16_t    flush_tmr     = 0;
+#    ifdef RGB_EFFECT_ENABLE
+static bool engine = false;
+
+// The main loop stops while suspended, so blank the strip right here, once:
+// QMK calls this on every pass of its suspend loop.
+void rgb_state_suspend(bool suspend) {
+    if (suspend == suspended) {
+        return;
+    }
+    suspended = suspend;
+    if (engine) {
+        rgb_effect_show(effective_on(), wanted.hue, wanted.sat, wanted.val);
+        rgb_effect_flush();
+    }
+}
+#    endif
+
+void rgb_state_request(bool on, uint8_t mode, uint8_t hue, uint8_t sat, uint8_t val) {
+    wanted.on   = on;
+    wanted.mode = mode;
+    wanted.hue  = hue;
+    wanted.sat  = sat;
+    wanted.val  = val;
+    dirty       = true;
+    TRACE(TRACE_RGB_REQUEST, hue);
+}
+
+#    ifdef RGB_STREAM_ENABLE
+static bool yielded = false;
+
+void rgb_state_yield(bool yield) {
+    yielded = yield;
+    if (yield) {
+        rgblight_disable_noeeprom();
+#        ifdef RGB_EFFECT_ENABLE
+        rgb_effect_stop();
+        engine = false;
+#        endif
+    }
+    applied_valid = false;
+    dirty         = true;
+}
+#    endif
+
+static bool hsv_differs(void) {
+    return wanted.hue != applied.hue || wanted.sat != applied.sat || wanted.val != applied.val;
+}
+
+static void apply_hsv(void) {
+    rgblight_sethsv_noeeprom(wanted.hue, wanted.sat, wanted.val);
+    applied.hue = wanted.hue;
+    applied.sat = wanted.sat;
+    applied.val = wanted.val;
+}
+
+void rgb_state_task(void) {
+#    ifdef RGB_STREAM_ENABLE
+    if (yielded) {
+        return;
+    }
+#    endif
+#    ifdef RGB_EFFECT_ENABLE
+    if (wanted.mode == RGB_EFFECT_MODE_LAYER) {
+        if (!engine) {
+            // rgblight would overwrite the engine's frames.
+            rgblight_disable_noeeprom();
+            engine = true;
+        }
+        rgb_effect_show(effective_on(), wanted.hue, wanted.sat, wanted.val);
+        dirty = false;
+        return;
+    }
+    if (engine) {
+        // rgblight is off; enable it again with the wanted state.
+        rgb_effect_stop();
+        engine        = false;
+        applied_valid = false;
+        dirty         = true;
+    }
+#    endif
+    if (!dirty || (applied_valid && timer_elapsed(flush_tmr) < RGB_STATE_REFRESH_MS)) {
+        return;
+    }
+
+    if (!applied_valid || wanted.on != applied.on) {
+        if (wanted.on) {
+            // Colour is latched silently while disabled, so enabling shows
+            // the new colour in the same frame.
+            apply_hsv();
+            rgblight_enable_noeeprom();
+        } else {
+            rgblight_disable_noeeprom();
+        }
+        applied.on    = wanted.on;
+        applied_valid = true;
+    } else if (wanted.on && wanted.mode != applied.mode) {
+        rgblight_mode_noeeprom(wanted.mode);
+        applied.mode = wanted.mode;
+    } else if (wanted.on && hsv_differs()) {
+        apply_hsv();
+    }
+
+    TRACE(TRACE_RGB_APPLY, applied.hue);
+
+    // While off, mode and colour changes stay pending until the next enable.
+    flush_tmr = timer_read();
+    dirty     = wanted.on && (wanted.mode != applied.mode || hsv_differs());
+}
+
+#endif
+#endif
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Interval in which queued RGB changes are coalesced into one LED frame.
+#ifndef RGB_STATE_REFRESH_MS
+#    define RGB_STATE_REFRESH_MS 10
+#endif
+
+// Records the wanted RGB state. Cheap enough to call from the key path; the
+// strip is only touched by rgb_state_task().
+void rgb_state_request(bool on, uint8_t mode, uint8_t hue, uint8_t sat, uint8_t val);
+
+// Applies at most one rgblight call (and so at most one LED frame) per
+// refresh tick, and only for the fields that differ from what is shown.
+void rgb_state_task(void);
+
+// Core 1 renderer and effect engine only: blanks the strip while the host is
+// suspended. Repeated calls with the same value do nothing.
+void rgb_state_suspend(bool suspend);
+
+// Raw HID stream only (rgb_stream.c): yield=true disables rgblight and the
+// effect engine and leaves the strip alone; false applies the wanted state
+// again.
+void rgb_state_yield(bool yield);
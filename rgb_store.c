@@ -0,0 +1,91 @@
+// RGB settings kept in RAM and written to the EEPROM emulation in one go.
+//
+// With the wear-leveling driver every EEPROM write may program (and now and
+// then erase) flash, which stops XIP and with it core 0 for the duration.
+// Writing on every RGB key would stall the scan each time, so the settings
+// are packed into the 32-bit user config word and written only after
+// RGB_STORE_QUIET_MS of no changes, or when the host suspends the keyboard.
+
+#include "quantum.h"
+#include "rgb_store.h"
+#include "trace.h"
+
+typedef union {
+    uint32_t raw;
+    struct {
+        bool    valid : 1;
+        bool    on : 1;
+        uint8_t mode_idx : 6;
+        uint8_t sat;
+        uint8_t val;
+    };
+} rgb_store_t;
+
+_Static_assert(sizeof(rgb_store_t) == sizeof(uint32_t), "must fit the user config word");
+
+static rgb_store_t       cached;
+static rgb_store_t       stored;
+static bool              dirty = false;
+static uint16_t          quiet_tmr;
+static rgb_store_stats_t stats;
+
+bool rgb_store_load(bool *on, uint8_t *mode_idx, uint8_t *sat, uint8_t *val) {
+    cached.raw = eeconfig_read_user();
+    stored     = cached;
+    if (!cached.valid) {
+        return false;
+    }
+    *on       = cached.on;
+    *mode_idx = cached.mode_idx;
+    *sat      = cached.sat;
+    *val      = cached.val;
+    return true;
+}
+
+void rgb_store_save(bool on, uint8_t mode_idx, uint8_t sat, uint8_t val) {
+    rgb_store_t next = {0};
+
+    next.valid    = true;
+    next.on       = on;
+    next.mode_idx = mode_idx;
+    next.sat      = sat;
+    next.val      = val;
+    if (next.raw == cached.raw) {
+        return;
+    }
+    // Changing a setting and changing it back needs no write at all.
+    cached    = next;
+    dirty     = cached.raw != stored.raw;
+    quiet_tmr = timer_read();
+}
+
+void rgb_store_flush(void) {
+    if (!dirty) {
+        return;
+    }
+    dirty  = false;
+    stored = cached;
+
+    uint32_t start = TRACE_NOW();
+    eeconfig_update_user(cached.raw);
+    uint32_t stall = TRACE_NOW() - start;
+
+    stats.writes++;
+    stats.stall_us_total += stall;
+    stats.stall_us_last = stall;
+    stats.stall_us_max  = MAX(stats.stall_us_max, stall);
+    TRACE(TRACE_FLASH_WRITE, stall);
+    if (debug_enable) {
+        dprintf("rgb_store: write %lu stalled %lu us (max %lu)\n", stats.writes, stall, stats.stall_us_max);
+    }
+}
+
+void rgb_store_task(void) {
+    if (dirty && timer_elapsed(quiet_tmr) >= RGB_STORE_QUIET_MS) {
+        rgb_store_flush();
+    }
+}
+
+const rgb_store_stats_t *rgb_store_stats(void) {
+    return &stats;
+}
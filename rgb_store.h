@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Time without RGB changes before the settings are written to flash.
+#ifndef RGB_STORE_QUIET_MS
+#    define RGB_STORE_QUIET_MS 3000
+#endif
+
+typedef struct {
+    uint32_t writes;
+    uint32_t stall_us_total;
+    uint32_t stall_us_max;
+    uint32_t stall_us_last;
+} rgb_store_stats_t;
+
+// Reads the saved settings; returns false (and leaves the arguments alone)
+// if nothing has been saved since the last EEPROM reset. Hue is not stored,
+// it follows the layer.
+bool rgb_store_load(bool *on, uint8_t *mode_idx, uint8_t *sat, uint8_t *val);
+
+// Updates the RAM copy. Only marks it dirty if something changed; the flash
+// write happens in rgb_store_task() once the settings stay put.
+void rgb_store_save(bool on, uint8_t mode_idx, uint8_t sat, uint8_t val);
+
+// Writes the settings after RGB_STORE_QUIET_MS without changes.
+void rgb_store_task(void);
+
+// Writes pending settings now, e.g. before the host suspends us.
+void rgb_store_flush(void);
+
+const rgb_store_stats_t *rgb_store_stats(void);
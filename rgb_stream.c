@@ -0,0 +1,86 @@
+// Host-driven LED frames (rgb_stream.h).
+//
+// Each packet is written into the WS2812 driver's buffer as it arrives,
+// with no frame copy in between; with WS2812_DMA_ENABLE that is the DMA back
+// buffer, through the gamma/brightness LUT. The show bit flushes it, which
+// never waits for the strip: a frame arriving while the previous one is
+// still on the wire replaces the pending one. Handling a packet costs a few
+// microseconds in the main loop, and none is answered, because a reply
+// would wait for the host to poll the IN endpoint.
+//
+// While frames keep coming rgb_state.c leaves the strip alone.
+
+#include "quantum.h"
+#include "rgb_stream.h"
+#include "rgb_state.h"
+#include "trace.h"
+#include "ws2812.h"
+
+static rgb_stream_stats_t stats;
+static bool               active = false;
+static bool               shown_any;
+static uint8_t            shown_frame;
+static uint32_t           frame_tmr;
+
+void rgb_stream_receive(const uint8_t *payload, uint8_t length) {
+    uint8_t first = payload[1];
+    uint8_t count = payload[2] & ~RGB_STREAM_SHOW;
+#ifdef LATENCY_TRACE_ENABLE
+    uint32_t start = TRACE_NOW();
+#endif
+
+    stats.packets++;
+    if (length < 3 + count * 3 || first + count > RGBLIGHT_LED_COUNT) {
+        stats.rejected++;
+        return;
+    }
+    if (!active) {
+        rgb_state_yield(true);
+        active    = true;
+        shown_any = false;
+    }
+    frame_tmr = timer_read32();
+
+    const uint8_t *rgb = &payload[3];
+    for (uint8_t i = 0; i < count; i++, rgb += 3) {
+        ws2812_set_color(first + i, rgb[0], rgb[1], rgb[2]);
+    }
+    if (!(payload[2] & RGB_STREAM_SHOW)) {
+        return;
+    }
+
+    ws2812_flush();
+    if (shown_any) {
+        stats.dropped += (uint8_t)(payload[0] - shown_frame - 1);
+    }
+    shown_any   = true;
+    shown_frame = payload[0];
+    stats.frames++;
+#ifdef LATENCY_TRACE_ENABLE
+    TRACE(TRACE_RGB_FRAME, TRACE_NOW() - start);
+#endif
+}
+
+void rgb_stream_stop(void) {
+    if (!active) {
+        return;
+    }
+    ws2812_set_color_all(0, 0, 0);
+    ws2812_flush();
+    active = false;
+    rgb_state_yield(false);
+}
+
+void rgb_stream_task(void) {
+    if (active && timer_elapsed32(frame_tmr) >= RGB_STREAM_TIMEOUT_MS) {
+        rgb_stream_stop();
+    }
+}
+
+bool rgb_stream_active(void) {
+    return active;
+}
+
+const rgb_stream_stats_t *rgb_stream_stats(void) {
+    return &stats;
+}
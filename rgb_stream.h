@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// LED frames streamed by the host over raw HID (HOST_CMD_LED_FRAME). A frame
+// is one or more packets
+//   [2] frame number  [3] first LED  [4] LEDs in packet, bit 7 = show
+//   [5..] R, G, B per LED
+// Colours go straight into the WS2812 driver's buffer; the packet with the
+// show bit pushes the frame. Packets are not answered.
+
+// Without frames for this long the strip goes back to rgblight or the effect
+// engine.
+#ifndef RGB_STREAM_TIMEOUT_MS
+#    define RGB_STREAM_TIMEOUT_MS 1000
+#endif
+
+#define RGB_STREAM_SHOW 0x80
+#define RGB_STREAM_LEDS_PER_PACKET 9
+
+typedef struct {
+    uint32_t packets;
+    uint32_t frames;   // frames pushed to the strip
+    uint32_t dropped;  // frame numbers skipped between two shown frames
+    uint32_t rejected; // packets with LEDs out of range or cut short
+} rgb_stream_stats_t;
+
+// payload is the packet from [2]. Takes the strip on the first packet.
+void rgb_stream_receive(const uint8_t *payload, uint8_t length);
+
+// Hands the strip back after RGB_STREAM_TIMEOUT_MS without frames.
+void rgb_stream_task(void);
+
+// Blanks the strip and hands it back, e.g. before a USB suspend.
+void rgb_stream_stop(void);
+
+bool rgb_stream_active(void);
+
+const rgb_stream_stats_t *rgb_stream_stats(void);
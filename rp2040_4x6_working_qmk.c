@@ -1 +1,158 @@
 #include "rp2040_4x6_working_qmk.h"
+#ifdef RGB_CORE1_ENABLE
+#    include "rgb_core1.h"
+#endif
+#ifdef WS2812_DMA_ENABLE
+#    include "ws2812_dma.h"
+#endif
+
+void keyboard_pre_init_kb(void) {
+    boot_time_mark(BOOT_KEYBOARD_INIT);
+    keyboard_pre_init_user();
+}
+
+void keyboard_post_init_kb(void) {
+    boot_time_mark(BOOT_POST_INIT);
+    // Needed by the first key lookup, so not deferred with the rest.
+#ifdef PROFILES_ENABLE
+    profile_init();
+#endif
+    keymap_cache_init();
+#ifdef CHORD_ENABLE
+    chord_init();
+#endif
+#if defined(RGBLIGHT_ENABLE) && defined(RGB_CORE1_ENABLE)
+    // Core 1 owns the strip; rgblight's own effects must not run on core 0.
+    rgblight_disable_noeeprom();
+    rgb_core1_init();
+#endif
+#ifndef FAST_BOOT_ENABLE
+    keyboard_post_init_user();
+    boot_time_mark(BOOT_USER_INIT);
+#endif
+}
+
+void housekeeping_task_kb(void) {
+#ifdef FAST_BOOT_ENABLE
+    // Settings and LEDs wait until the host has configured us, so nothing
+    // competes with the first scans and enumeration.
+    if (boot_time_task()) {
+        keyboard_post_init_user();
+        boot_time_mark(BOOT_USER_INIT);
+    }
+#else
+    boot_time_task();
+#endif
+#ifdef LATENCY_TRACE_ENABLE
+    trace_task();
+#endif
+#ifdef CHORD_ENABLE
+    chord_task();
+#endif
+    macro_seq_task();
+#ifdef RGB_STREAM_ENABLE
+    rgb_stream_task();
+#endif
+#ifdef RGBLIGHT_ENABLE
+    rgb_state_task();
+#    ifdef RGB_EFFECT_ENABLE
+    rgb_effect_task();
+#    endif
+#endif
+    rgb_store_task();
+#ifdef WS2812_DMA_ENABLE
+    ws2812_dma_task();
+#endif
+#ifdef MOUSE_ENABLE
+    mouse_batch_task();
+#endif
+    housekeeping_task_user();
+#ifdef REPORT_COALESCE_ENABLE
+    report_coalesce_task();
+#endif
+#ifdef POWER_SAVE_ENABLE
+    // Last: sleeping here is the gap until the next scan.
+    power_task();
+#endif
+}
+
+#if defined(CHORD_ENABLE) && !defined(COMBO_ENABLE) && !defined(REPEAT_KEY_ENABLE)
+#    error "CHORD_ENABLE needs REPEAT_KEY_ENABLE or COMBO_ENABLE, without them QMK never calls pre_process_record_kb()"
+#endif
+
+#ifdef CHORD_ENABLE
+bool HOT_PATH(pre_process_record_kb)(uint16_t keycode, keyrecord_t *record) {
+    if (!chord_process(record)) {
+        return false;
+    }
+    return pre_process_record_user(keycode, record);
+}
+#endif
+
+bool HOT_PATH(process_record_kb)(uint16_t keycode, keyrecord_t *record) {
+#ifdef POWER_SAVE_ENABLE
+    // Held while USB is down and passed through here again later.
+    if (!power_process(record)) {
+        return false;
+    }
+#endif
+    keymap_cache_process(keycode, record);
+    TRACE(TRACE_RECORD_ENTER, keycode);
+    boot_time_mark(BOOT_FIRST_KEY);
+    bool result = true;
+#ifdef PROFILES_ENABLE
+    result = result && profile_process(keycode, record);
+#endif
+#ifdef TAP_HOLD_ENABLE
+    result = result && tap_hold_process(keycode, record);
+#endif
+#if defined(MOUSE_ENABLE) && defined(MOUSE_MOTION_ENABLE)
+    result = result && mouse_motion_process(keycode, record);
+#endif
+    result = result && process_record_user(keycode, record);
+    TRACE(TRACE_RECORD_EXIT, keycode);
+    return result;
+}
+
+#ifdef DYNAMIC_KEYMAP_ENABLE
+// Last step of eeconfig_init(), after the keymap in EEPROM was reset.
+void eeconfig_init_kb(void) {
+    keymap_cache_reload();
+    eeconfig_init_user();
+}
+#endif
+
+layer_state_t layer_state_set_kb(layer_state_t state) {
+    TRACE(TRACE_LAYER, state);
+    state = layer_state_set_user(state);
+    keymap_cache_set_layers(state | default_layer_state);
+    return state;
+}
+
+layer_state_t default_layer_state_set_kb(layer_state_t state) {
+    state = default_layer_state_set_user(state);
+    keymap_cache_set_layers(layer_state | state);
+    return state;
+}
+
+void suspend_power_down_kb(void) {
+    // Flash writes are slow; better now than losing them to an unplug.
+    rgb_store_flush();
+#ifdef RGB_STREAM_ENABLE
+    rgb_stream_stop();
+#endif
+#if defined(RGBLIGHT_ENABLE) && (defined(RGB_CORE1_ENABLE) || defined(RGB_EFFECT_ENABLE))
+    rgb_state_suspend(true);
+#endif
+    suspend_power_down_user();
+#ifdef POWER_SAVE_ENABLE
+    power_suspend();
+#endif
+}
+
+#if defined(RGBLIGHT_ENABLE) && (defined(RGB_CORE1_ENABLE) || defined(RGB_EFFECT_ENABLE))
+void suspend_wakeup_init_kb(void) {
+    rgb_state_suspend(false);
+    suspend_wakeup_init_user();
+}
+#endif
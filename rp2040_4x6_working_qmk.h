@@ -1,3 +1,23 @@
 #pragma once
 
 #include "quantum.h"
+#include "rgb_state.h"
+#include "rgb_store.h"
+#include "rgb_effect.h"
+#include "rgb_stream.h"
+#include "mouse_batch.h"
+#include "mouse_motion.h"
+#include "macro_seq.h"
+#include "chord.h"
+#include "tap_hold.h"
+#include "trace.h"
+#include "boot_time.h"
+#include "power.h"
+#include "report_coalesce.h"
+#include "keymap_cache.h"
+#include "profile.h"
+#include "hot_path.h"
+
+#ifdef PIO_MATRIX_ENABLE
+#    include "matrix_pio.h"
+#endif
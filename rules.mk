@@ -8,5 +8,152 @@ MOUSEKEY_ENABLE = yes
 LTO_ENABLE = no
 WEAR_LEVELING_DRIVER = rp2040_flash
 
+CUSTOM_MATRIX = lite
+SRC += matrix.c
+SRC += rgb_state.c
+SRC += rgb_store.c
+SRC += mouse_batch.c
+SRC += host_cmd.c
+SRC += keymap_cache.c
+SRC += rgb_effect.c
+SRC += macro_seq.c
+SRC += boot_time.c
 
+# RP2040 PIO/DMA matrix scanner, see matrix_pio.c
+PIO_MATRIX_ENABLE ?= no
+ifeq ($(strip $(PIO_MATRIX_ENABLE)), yes)
+    SRC += matrix_pio.c
+    OPT_DEFS += -DPIO_MATRIX_ENABLE
+endif
 
+# RP2040 PIO quadrature decoder for the rotary encoder, see encoder_pio.c
+PIO_ENCODER_ENABLE ?= no
+ifeq ($(strip $(PIO_ENCODER_ENABLE)), yes)
+    ENCODER_DRIVER = custom
+    SRC += encoder_pio.c
+endif
+
+# Eager press / deferred release per-key debounce, see debounce_eager.c.
+# DEBOUNCE (ms, config.h) sets the release delay. "no" falls back to QMK's
+# default sym_defer_g.
+EAGER_DEBOUNCE_ENABLE ?= yes
+ifeq ($(strip $(EAGER_DEBOUNCE_ENABLE)), yes)
+    DEBOUNCE_TYPE = custom
+    SRC += debounce_eager.c
+endif
+
+# Scan-to-USB latency trace read out over raw HID, see trace.h and
+# tools/trace_decode.py
+LATENCY_TRACE_ENABLE ?= no
+ifeq ($(strip $(LATENCY_TRACE_ENABLE)), yes)
+    RAW_ENABLE = yes
+    SRC += trace.c
+    OPT_DEFS += -DLATENCY_TRACE_ENABLE
+endif
+
+# Bitmask chords from chords.def, see chord.c. QMK only calls
+# pre_process_record_kb() with COMBO_ENABLE or REPEAT_KEY_ENABLE.
+CHORD_ENABLE ?= yes
+ifeq ($(strip $(CHORD_ENABLE)), yes)
+    REPEAT_KEY_ENABLE = yes
+    SRC += chord.c
+    OPT_DEFS += -DCHORD_ENABLE
+endif
+
+# Tap keycodes on the MO() keys without delaying other keys, see tap_hold.c
+TAP_HOLD_ENABLE ?= yes
+ifeq ($(strip $(TAP_HOLD_ENABLE)), yes)
+    SRC += tap_hold.c
+    OPT_DEFS += -DTAP_HOLD_ENABLE
+endif
+
+# Keymap profiles packed into flash by tools/profiles.py and switched with
+# PF_NEXT or raw HID, see profile.h
+PROFILES_ENABLE ?= yes
+ifeq ($(strip $(PROFILES_ENABLE)), yes)
+    SRC += profile.c
+    OPT_DEFS += -DPROFILES_ENABLE
+endif
+
+# Mouse key movement from the hold time on the microsecond timer instead of
+# per-report steps, sent with the wheel by mouse_batch.c, see mouse_motion.c
+MOUSE_MOTION_ENABLE ?= yes
+ifeq ($(strip $(MOUSE_MOTION_ENABLE)), yes)
+    SRC += mouse_motion.c
+    OPT_DEFS += -DMOUSE_MOTION_ENABLE
+endif
+
+# Skip the double-tap reset window (bootmagic instead) and run
+# keyboard_post_init_user() once USB is configured, see boot_time.h and
+# tools/trace_decode.py --boot
+FAST_BOOT_ENABLE ?= no
+ifeq ($(strip $(FAST_BOOT_ENABLE)), yes)
+    OPT_DEFS += -DFAST_BOOT_ENABLE
+endif
+
+# Sleep between scans when idle and during USB suspend, woken by key and
+# encoder edges, see power.c. Needs the CPU matrix scan.
+POWER_SAVE_ENABLE ?= yes
+ifeq ($(strip $(POWER_SAVE_ENABLE)), yes)
+    ifneq ($(strip $(PIO_MATRIX_ENABLE)), yes)
+        SRC += power.c
+        OPT_DEFS += -DPOWER_SAVE_ENABLE
+    endif
+endif
+
+# One keyboard/NKRO report per main loop and USB frame for all key events
+# of a scan, see report_coalesce.c
+REPORT_COALESCE_ENABLE ?= yes
+ifeq ($(strip $(REPORT_COALESCE_ENABLE)), yes)
+    SRC += report_coalesce.c
+    OPT_DEFS += -DREPORT_COALESCE_ENABLE
+endif
+
+# Run the scan-to-report path from SRAM instead of XIP flash, see hot_path.h.
+# Compare with LATENCY_TRACE_ENABLE=yes and tools/trace_decode.py --loop-stats.
+SRAM_HOT_PATH_ENABLE ?= no
+ifeq ($(strip $(SRAM_HOT_PATH_ENABLE)), yes)
+    OPT_DEFS += -DSRAM_HOT_PATH_ENABLE
+endif
+
+# Render the WS2812 strip on core 1 instead of rgblight on core 0, see
+# rgb_core1.c
+RGB_CORE1_ENABLE ?= no
+ifeq ($(strip $(RGB_CORE1_ENABLE)), yes)
+    WS2812_DRIVER = custom
+    SRC += rgb_core1.c
+    OPT_DEFS += -DRGB_CORE1_ENABLE
+endif
+
+# Per-layer fixed-point effects from rgb_layers.def as an extra RGB mode, see
+# rgb_effect.c. Not available with RGB_CORE1_ENABLE.
+RGB_EFFECT_ENABLE ?= yes
+ifeq ($(strip $(RGB_EFFECT_ENABLE)), yes)
+    ifneq ($(strip $(RGB_CORE1_ENABLE)), yes)
+        OPT_DEFS += -DRGB_EFFECT_ENABLE
+    endif
+endif
+
+# LED frames streamed by the host over raw HID, written straight into the
+# WS2812 buffer, see rgb_stream.c and tools/led_stream.py. Not available with
+# RGB_CORE1_ENABLE.
+RGB_STREAM_ENABLE ?= no
+ifeq ($(strip $(RGB_STREAM_ENABLE)), yes)
+    ifneq ($(strip $(RGB_CORE1_ENABLE)), yes)
+        RAW_ENABLE = yes
+        SRC += rgb_stream.c
+        OPT_DEFS += -DRGB_STREAM_ENABLE
+    endif
+endif
+
+# Double-buffered DMA WS2812 output with a gamma/brightness LUT, see
+# ws2812_dma.c
+WS2812_DMA_ENABLE ?= no
+ifeq ($(strip $(WS2812_DMA_ENABLE)), yes)
+    ifeq ($(strip $(RGB_CORE1_ENABLE)), yes)
+        $(error WS2812_DMA_ENABLE and RGB_CORE1_ENABLE both drive the strip, pick one)
+    endif
+    WS2812_DRIVER = custom
+    SRC += ws2812_dma.c
+    OPT_DEFS += -DWS2812_DMA_ENABLE
+endif
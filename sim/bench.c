@@ -0,0 +1,164 @@
+// Replays synthetic key and encoder streams through a keymap and reports the
+// host CPU cost per event together with the device-side work each event
+// causes (HID reports, rgblight calls and WS2812 frames).
+
+#include <stdio.h>
+#include <time.h>
+#include "sim.h"
+#include "mouse_batch.h"
+#include "rgb_store.h"
+
+#define REPEAT 2000
+#define SCAN_US 1000
+
+typedef struct {
+    const char *name;
+    uint32_t (*run)(void);
+} scenario_t;
+
+static uint64_t wall_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void step(void) {
+    sim_advance_us(SCAN_US);
+    sim_scan();
+}
+
+static uint32_t key(uint8_t row, uint8_t col, bool pressed) {
+    sim_key(row, col, pressed);
+    step();
+    return 1;
+}
+
+static uint32_t tap(uint8_t row, uint8_t col) {
+    return key(row, col, true) + key(row, col, false);
+}
+
+static uint32_t run_numpad_typing(void) {
+    static const uint8_t digits[][2] = {{2, 0}, {2, 1}, {2, 2}, {3, 0}, {3, 1}, {3, 2}, {4, 0}, {4, 1}, {4, 2}, {5, 1}, {5, 2}, {4, 3}};
+    uint32_t             events = 0;
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(digits); i++) {
+        events += tap(digits[i][0], digits[i][1]);
+    }
+    return events;
+}
+
+static uint32_t run_layer_flips(void) {
+    uint32_t events = 0;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        events += tap(0, 1);
+    }
+    return events;
+}
+
+static uint32_t run_hue_burst(void) {
+    uint32_t events = key(0, 2, true);
+
+    for (uint8_t i = 0; i < 8; i++) {
+        events += tap(1, 2);
+    }
+    return events + key(0, 2, false);
+}
+
+// Eight brightness steps, up and down on alternate runs, then a pause long
+// enough for the settings store to write.
+static uint32_t run_val_burst(void) {
+    static uint8_t run      = 0;
+    uint32_t       events   = key(0, 2, true);
+    uint8_t        val_step = run++ & 1;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        events += tap(2, val_step);
+    }
+    events += key(0, 2, false);
+    for (uint16_t i = 0; i < RGB_STORE_QUIET_MS; i++) {
+        step();
+    }
+    return events;
+}
+
+static uint32_t run_encoder_spin(void) {
+    uint32_t events = 0;
+
+    for (uint8_t i = 0; i < 16; i++) {
+        sim_encoder(i < 8);
+        step();
+        events++;
+    }
+    return events;
+}
+
+// A fast flick: four detents land between two scans, as the PIO decoder
+// delivers them.
+static uint32_t run_encoder_flick(void) {
+    uint32_t events = 0;
+
+    for (uint8_t i = 0; i < 8; i++) {
+        for (uint8_t d = 0; d < 4; d++) {
+            sim_encoder(true);
+            events++;
+        }
+        step();
+    }
+    for (uint8_t i = 0; i < MOUSE_BATCH_INTERVAL_MS; i++) {
+        step();
+    }
+    return events;
+}
+
+static uint32_t run_encoder_button(void) {
+    uint32_t events = 0;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        events += tap(ENCODER_BTN_ROW, ENCODER_BTN_COL);
+    }
+    return events;
+}
+
+static uint32_t run_idle_scan(void) {
+    for (uint8_t i = 0; i < 64; i++) {
+        step();
+    }
+    return 64;
+}
+
+static const scenario_t scenarios[] = {
+    {"numpad_typing", run_numpad_typing},
+    {"layer_flips", run_layer_flips},
+    {"mo4_hue_burst", run_hue_burst},
+    {"mo4_val_burst", run_val_burst},
+    {"encoder_spin", run_encoder_spin},
+    {"encoder_flick", run_encoder_flick},
+    {"encoder_button", run_encoder_button},
+    {"idle_scan", run_idle_scan},
+};
+
+static void bench(const scenario_t *scenario) {
+    sim_init();
+    scenario->run();
+    sim_init();
+
+    uint32_t events = 0;
+    uint64_t start  = wall_ns();
+    for (uint32_t i = 0; i < REPEAT; i++) {
+        events += scenario->run();
+    }
+    double ns = (double)(wall_ns() - start);
+    double n  = (double)events;
+
+    printf("%-16s %8u %10.1f %10.2f %10.2f %10.2f %10.2f %10.2f %10.1f %10.3f\n", scenario->name, events / REPEAT, ns / n, sim_stats.rgb_calls / n, sim_stats.led_frames / n, sim_stats.key_reports / n, sim_stats.mouse_reports / n, sim_stats.wheel_units / n, (double)sim_stats.led_frames * SIM_WS2812_FRAME_US / n, sim_stats.flash_writes / n);
+}
+
+int main(void) {
+    printf("keymap: %s (ns/event includes the scan that follows each event)\n", SIM_KEYMAP);
+    printf("%-16s %8s %10s %10s %10s %10s %10s %10s %10s %10s\n", "scenario", "events", "ns/event", "rgb/ev", "frames/ev", "kbrep/ev", "msrep/ev", "wheel/ev", "strip_us/ev", "flash/ev");
+    for (uint8_t i = 0; i < ARRAY_SIZE(scenarios); i++) {
+        bench(&scenarios[i]);
+    }
+    return 0;
+}
@@ -0,0 +1,62 @@
+// Boots the default keymap with FAST_BOOT_ENABLE against a host that takes
+// SIM_ENUM_MS to configure the keyboard, checks that the settings and LEDs
+// wait for it, and reads the boot timeline out through the raw HID command
+// the way a host would:
+//   ./build/boot_dump | ../tools/trace_decode.py --boot --input -
+// The simulator starts at keyboard init, so everything before it (boot ROM,
+// ChibiOS startup, the double-tap window) is 0 here; on the device those
+// show in keyboard_init.
+
+#include <stdio.h>
+#include "sim.h"
+#include "host_cmd.h"
+#include "raw_hid.h"
+#include "usb_main.h"
+
+#define SCAN_US 1000
+#define SIM_ENUM_MS 120
+#define KEY_AT_MS 40
+#define PACKET 32
+
+void raw_hid_send(uint8_t *data, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        printf("%02x", data[i]);
+    }
+    printf("\n");
+}
+
+static void step(void) {
+    sim_advance_us(SCAN_US);
+    sim_scan();
+}
+
+int main(void) {
+    keyboard_pre_init_kb();
+    sim_init();
+    sim_usb_driver.state = USB_READY;
+
+    for (uint16_t ms = 0; ms < SIM_ENUM_MS; ms++) {
+        step();
+    }
+    bool dark = sim_stats.rgb_calls == 0 && sim_stats.led_frames == 0;
+
+    sim_usb_driver.state = USB_ACTIVE;
+    for (uint16_t ms = 0; ms < KEY_AT_MS; ms++) {
+        step();
+    }
+    bool lit = sim_stats.rgb_calls > 0;
+
+    sim_key(4, 0, true);
+    step();
+    sim_key(4, 0, false);
+    step();
+
+    uint8_t packet[PACKET] = {HOST_CMD_ID, HOST_CMD_BOOT_TIMELINE};
+    raw_hid_receive(packet, sizeof(packet));
+
+    if (!dark || !lit) {
+        fprintf(stderr, "RGB %s\n", dark ? "never started" : "started before USB was configured");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,286 @@
+// Chord engine: behaviour of the chords in chords.def through the default
+// keymap, then the cost of matching one key event against 5 to 255 random
+// chords, by table lookup (chord.c) and by walking every chord's key list
+// the way QMK's combo code does.
+//   make chords
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+#include "chord.h"
+
+#define SCAN_US 1000
+#define EVENTS 100000
+#define MAX_CHORDS 255
+#define MATRIX_KEYS 24
+
+typedef struct {
+    const char *name;
+    bool (*run)(void);
+} check_t;
+
+static report_keyboard_t last;
+static uint32_t          reports;
+static host_driver_t    *sim_driver;
+static host_driver_t     capture;
+
+static uint64_t wall_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static void capture_keyboard(report_keyboard_t *report) {
+    sim_driver->send_keyboard(report);
+    last = *report;
+    reports++;
+}
+
+static void start(void) {
+    sim_init();
+    sim_driver            = host_get_driver();
+    capture               = *sim_driver;
+    capture.send_keyboard = capture_keyboard;
+    host_set_driver(&capture);
+    memset(&last, 0, sizeof(last));
+    reports = 0;
+}
+
+static void scans(uint32_t n) {
+    for (uint32_t i = 0; i < n; i++) {
+        sim_advance_us(SCAN_US);
+        sim_scan();
+    }
+}
+
+static bool shows(uint8_t mods, uint8_t key) {
+    return last.mods == mods && last.keys[0] == key;
+}
+
+// Every key of layer 0 outside the chords reports in the same scan.
+static bool check_no_delay(void) {
+    static const uint8_t keys[][2] = {{0, 3}, {1, 0}, {1, 1}, {1, 2}, {1, 3}, {2, 0}, {2, 1}, {2, 2}, {2, 3}, {3, 0}, {3, 1}, {3, 2}, {4, 0}, {4, 1}, {4, 2}, {4, 3}, {5, 1}, {5, 2}};
+
+    start();
+    for (uint8_t i = 0; i < ARRAY_SIZE(keys); i++) {
+        uint32_t before = reports;
+        sim_key(keys[i][0], keys[i][1], true);
+        if (reports != before + 1) {
+            return false;
+        }
+        sim_key(keys[i][0], keys[i][1], false);
+        scans(1);
+    }
+    return true;
+}
+
+// No longer chord contains it: fires on the second press.
+static bool check_immediate(void) {
+    start();
+    sim_key(0, 0, true);
+    bool waited = reports == 0;
+    sim_key(3, 3, true);
+    bool fired = shows(0x01, KC_A);
+    sim_key(0, 0, false);
+    bool released = last.keys[0] == 0 && last.mods == 0;
+    sim_key(3, 3, false);
+    return waited && fired && released && reports == 4;
+}
+
+// ESC is part of the redo chord, so it fires on the first release.
+static bool check_on_release(void) {
+    start();
+    sim_key(0, 0, true);
+    sim_key(5, 0, true);
+    bool waited = reports == 0;
+    sim_key(5, 0, false);
+    bool tapped = reports == 2 && last.keys[0] == 0;
+    sim_key(0, 0, false);
+    return waited && tapped && reports == 2;
+}
+
+static bool check_longest(void) {
+    start();
+    sim_key(0, 0, true);
+    sim_key(5, 0, true);
+    sim_key(5, 3, true);
+    bool fired = shows(0x01, KC_Y);
+    sim_key(5, 3, false);
+    sim_key(5, 0, false);
+    sim_key(0, 0, false);
+    return fired && reports == 4 && last.mods == 0 && last.keys[0] == 0;
+}
+
+// ESC held past CHORD_TERM_MS fires without a release.
+static bool check_term(void) {
+    start();
+    sim_key(0, 0, true);
+    sim_key(5, 0, true);
+    scans(CHORD_TERM_MS + 1);
+    bool fired = shows(0, KC_ESC);
+    sim_key(0, 0, false);
+    sim_key(5, 0, false);
+    return fired && reports == 2;
+}
+
+// A key in no chord settles the waiting corner and reports at once.
+static bool check_interrupt(void) {
+    start();
+    sim_key(0, 0, true);
+    sim_key(3, 1, true);
+    bool at_once = shows(0, KC_P5);
+    sim_key(3, 1, false);
+    sim_key(3, 3, true);
+    bool no_chord = reports == 2;
+    sim_key(0, 0, false);
+    sim_key(3, 3, false);
+    scans(CHORD_TERM_MS + 1);
+    return at_once && no_chord && reports == 2;
+}
+
+static const check_t checks[] = {
+    {"no_delay", check_no_delay}, {"immediate", check_immediate}, {"on_release", check_on_release}, {"longest", check_longest}, {"term", check_term}, {"interrupt", check_interrupt},
+};
+
+// QMK-style combos: a key list per combo, walked for every event.
+typedef struct {
+    keypos_t keys[CHORD_MAX_KEYS];
+    uint8_t  count;
+} combo_t;
+
+static chord_t       chords[MAX_CHORDS];
+static combo_t       combos[MAX_CHORDS];
+static chord_entry_t entries[MAX_CHORDS * ((1 << CHORD_MAX_KEYS) - 1)];
+static uint32_t      events[EVENTS];
+static uint32_t      rng = 1;
+
+static uint32_t next_random(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 8;
+}
+
+static uint32_t random_key(void) {
+    uint8_t index = next_random() % MATRIX_KEYS;
+    return CHORD_KEY(index / MATRIX_COLS, index % MATRIX_COLS);
+}
+
+static void make_chords(uint16_t count) {
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t  size = 2 + next_random() % (CHORD_MAX_KEYS - 1);
+        uint32_t keys = 0;
+        while (__builtin_popcount(keys) < size) {
+            keys |= random_key();
+        }
+        chords[i] = (chord_t){.keycode = KC_A + i % 26, .keys = keys};
+        combos[i].count = 0;
+        for (uint8_t bit = 0; bit < 32; bit++) {
+            if (keys & (1u << bit)) {
+                combos[i].keys[combos[i].count++] = (keypos_t){.row = bit / MATRIX_COLS, .col = bit % MATRIX_COLS};
+            }
+        }
+    }
+}
+
+// Half parts of chords, half random sets of one to three keys.
+static void make_events(uint16_t count) {
+    for (uint32_t i = 0; i < EVENTS; i++) {
+        if (i & 1) {
+            uint32_t keys = chords[next_random() % count].keys;
+            uint32_t part = keys & next_random();
+            events[i]     = part ? part : keys;
+        } else {
+            events[i] = 0;
+            for (uint8_t n = 1 + next_random() % 3; n; n--) {
+                events[i] |= random_key();
+            }
+        }
+    }
+}
+
+static bool pressed(uint32_t keys, keypos_t key) {
+    return keys & CHORD_KEY(key.row, key.col);
+}
+
+// What the table says, found by walking: 1 = part of a chord, +2 = a chord,
+// +4 = a longer chord exists.
+static uint8_t scan(uint32_t keys, uint16_t count) {
+    uint8_t found = 0;
+    bool    exact = false;
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint8_t held = 0;
+        for (uint8_t k = 0; k < combos[i].count; k++) {
+            held += pressed(keys, combos[i].keys[k]);
+        }
+        if (held != __builtin_popcount(keys)) {
+            continue;
+        }
+        found |= 1;
+        if (held == combos[i].count) {
+            exact = true;
+        } else {
+            found |= 4;
+        }
+    }
+    return found | (exact ? 2 : 0);
+}
+
+static uint8_t lookup(const chord_table_t *table, uint32_t keys) {
+    const chord_entry_t *entry = chord_table_find(table, keys);
+
+    if (!entry) {
+        return 0;
+    }
+    return 1 | (entry->chord ? 2 : 0) | (entry->extends ? 4 : 0);
+}
+
+static uint32_t match_cost(uint16_t count, double *table_ns, double *scan_ns, uint16_t *table_entries) {
+    chord_table_t     table;
+    volatile uint32_t sink = 0;
+    uint32_t          bad  = 0;
+
+    make_chords(count);
+    make_events(count);
+    chord_table_build(&table, entries, chords, count);
+    *table_entries = table.count;
+
+    for (uint32_t i = 0; i < EVENTS; i++) {
+        bad += lookup(&table, events[i]) != scan(events[i], count);
+    }
+
+    uint64_t t0 = wall_ns();
+    for (uint32_t i = 0; i < EVENTS; i++) {
+        sink += lookup(&table, events[i]);
+    }
+    uint64_t t1 = wall_ns();
+    for (uint32_t i = 0; i < EVENTS; i++) {
+        sink += scan(events[i], count);
+    }
+    uint64_t t2 = wall_ns();
+
+    *table_ns = (double)(t1 - t0) / EVENTS;
+    *scan_ns  = (double)(t2 - t1) / EVENTS;
+    return bad;
+}
+
+int main(void) {
+    static const uint16_t counts[] = {5, 16, 64, 255};
+    uint32_t              bad      = 0;
+
+    for (uint8_t i = 0; i < ARRAY_SIZE(checks); i++) {
+        bool ok = checks[i].run();
+        printf("%-12s %s\n", checks[i].name, ok ? "ok" : "FAILED");
+        bad += !ok;
+    }
+
+    printf("\n%-8s %8s %10s %10s %10s\n", "chords", "entries", "table_ns", "scan_ns", "mismatch");
+    for (uint8_t i = 0; i < ARRAY_SIZE(counts); i++) {
+        double   table_ns, scan_ns;
+        uint16_t table_entries;
+        uint32_t wrong = match_cost(counts[i], &table_ns, &scan_ns, &table_entries);
+        printf("%-8u %8u %10.1f %10.1f %10u\n", counts[i], table_entries, table_ns, scan_ns, wrong);
+        bad += wrong;
+    }
+    return bad ? 1 : 0;
+}
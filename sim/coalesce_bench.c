@@ -0,0 +1,258 @@
+// Burst input through the default keymap with and without report
+// coalescing (report_coalesce.c): keys changing in the same scan, taps that
+// start and end within one scan, and layer-1 shortcuts released together
+// with MO(1). For every event it finds the first report that shows it and
+// prints the reports sent, the latency from the event's scan to that
+// report, the longest the loop was held up sending, and events the host
+// never saw.
+//   make coalesce
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#ifdef REPORT_COALESCE_ENABLE
+#    include "report_coalesce.h"
+#    define PATH "coalesced"
+#else
+#    define PATH "per event"
+#endif
+
+// Main loop period with the CPU scan; tools/trace_decode.py --loop-stats
+// measures the real one.
+#define SCAN_US 100
+#define MAX_EVENTS 8192
+#define MAX_REPORTS 16384
+
+typedef struct {
+    uint64_t at;
+    uint32_t reports_before;
+    uint8_t  code;
+    bool     pressed;
+} event_t;
+
+typedef struct {
+    uint64_t at;
+    uint8_t  keys[6];
+} sent_t;
+
+static const uint8_t digits[][2] = {{4, 0}, {4, 1}, {4, 2}, {3, 0}, {3, 1}, {3, 2}, {2, 0}, {2, 1}, {2, 2}, {5, 1}};
+
+static host_driver_t *sim_driver;
+static host_driver_t  capture;
+static event_t        events[MAX_EVENTS];
+static sent_t         sent[MAX_REPORTS];
+static uint32_t       event_count;
+static uint32_t       sent_count;
+static uint32_t       max_stall;
+static uint32_t       rng = 7;
+#ifdef REPORT_COALESCE_ENABLE
+static uint32_t saved_before;
+#endif
+
+static uint32_t next_random(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 8;
+}
+
+static void capture_keyboard(report_keyboard_t *report) {
+    sim_driver->send_keyboard(report);
+    if (sent_count < MAX_REPORTS) {
+        sent[sent_count].at = sim_now_us();
+        memcpy(sent[sent_count].keys, report->keys, sizeof(report->keys));
+        sent_count++;
+    }
+}
+
+static void start(void) {
+    sim_init();
+    sim_driver            = host_get_driver();
+    capture               = *sim_driver;
+    capture.send_keyboard = capture_keyboard;
+    host_set_driver(&capture);
+    event_count = 0;
+    sent_count  = 0;
+    max_stall   = 0;
+    sim_scan();
+#ifdef REPORT_COALESCE_ENABLE
+    saved_before = report_coalesce_stats()->reports_in - report_coalesce_stats()->reports_out;
+#endif
+}
+
+// code is the basic keycode the event shows in the report, 0 for none.
+static void key(uint8_t row, uint8_t col, bool pressed, uint8_t code, uint64_t scan_at) {
+    if (code && event_count < MAX_EVENTS) {
+        events[event_count++] = (event_t){scan_at, sent_count, code, pressed};
+    }
+    sim_key(row, col, pressed);
+}
+
+// One scan: the events, then the rest of the loop. Time only passes inside
+// the loop while a report waits for the USB poll.
+typedef void (*scan_events_t)(uint64_t scan_at);
+
+static void scan(scan_events_t run) {
+    uint64_t at = sim_now_us();
+
+    if (run) {
+        run(at);
+    }
+    sim_scan();
+    max_stall = MAX(max_stall, (uint32_t)(sim_now_us() - at));
+    sim_advance_us(SCAN_US);
+}
+
+static void idle(uint16_t scans) {
+    for (uint16_t i = 0; i < scans; i++) {
+        scan(NULL);
+    }
+}
+
+static bool shows(const sent_t *report, uint8_t code) {
+    for (uint8_t i = 0; i < 6; i++) {
+        if (report->keys[i] == code) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int compare(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+static uint8_t held[ARRAY_SIZE(digits)];
+static uint8_t burst[4];
+static uint8_t burst_size;
+
+static void press_burst(uint64_t at) {
+    for (uint8_t i = 0; i < burst_size; i++) {
+        key(digits[burst[i]][0], digits[burst[i]][1], true, KC_P1 + burst[i], at);
+    }
+}
+
+static void release_burst(uint64_t at) {
+    for (uint8_t i = 0; i < burst_size; i++) {
+        key(digits[burst[i]][0], digits[burst[i]][1], false, KC_P1 + burst[i], at);
+    }
+}
+
+// Two to four digits pressed in one scan and released together.
+static void chorded(void) {
+    for (uint8_t round = 0; round < 200; round++) {
+        burst_size = 2 + next_random() % 3;
+        for (uint8_t i = 0; i < burst_size; i++) {
+            burst[i] = (round + i * 2) % 9;
+        }
+        scan(press_burst);
+        idle(300 + next_random() % 500);
+        scan(release_burst);
+        idle(300 + next_random() % 500);
+    }
+}
+
+// Digit index 9 is KC_P0 at (5,1); the rest are KC_P1.. in order.
+static uint8_t code_of(uint8_t digit) {
+    return digit == 9 ? KC_P0 : KC_P1 + digit;
+}
+
+static void rolling_scan(uint64_t at) {
+    uint8_t changes = 1 + next_random() % 3;
+
+    for (uint8_t n = 0; n < changes; n++) {
+        uint8_t d = next_random() % ARRAY_SIZE(digits);
+        if (held[d]) {
+            held[d] = 0;
+            key(digits[d][0], digits[d][1], false, code_of(d), at);
+        } else if (next_random() % 8 == 0) {
+            // Pressed and released between two scans.
+            key(digits[d][0], digits[d][1], true, code_of(d), at);
+            key(digits[d][0], digits[d][1], false, code_of(d), at);
+        } else if (held[0] + held[1] + held[2] + held[3] + held[4] + held[5] + held[6] + held[7] + held[8] + held[9] < 5) {
+            held[d] = 1;
+            key(digits[d][0], digits[d][1], true, code_of(d), at);
+        }
+    }
+}
+
+// Fast entry: one to three keys change per busy scan.
+static void rolling(void) {
+    memset(held, 0, sizeof(held));
+    for (uint16_t i = 0; i < 3000; i++) {
+        scan(rolling_scan);
+        idle(next_random() % 200);
+    }
+    for (uint8_t d = 0; d < ARRAY_SIZE(digits); d++) {
+        if (held[d]) {
+            sim_key(digits[d][0], digits[d][1], false);
+        }
+    }
+}
+
+static void hold_layer(uint64_t at) {
+    key(0, 1, true, 0, at);
+}
+
+static void press_copy(uint64_t at) {
+    key(2, 3, true, KC_C, at);
+}
+
+static void release_both(uint64_t at) {
+    key(2, 3, false, KC_C, at);
+    key(0, 1, false, 0, at);
+}
+
+// MO(1) held for LCTL(KC_C), both let go in the same scan.
+static void shortcut(void) {
+    for (uint8_t round = 0; round < 100; round++) {
+        scan(hold_layer);
+        idle(400);
+        scan(press_copy);
+        idle(600);
+        scan(release_both);
+        idle(1000);
+    }
+}
+
+typedef struct {
+    const char *name;
+    void (*run)(void);
+} stream_t;
+
+static const stream_t streams[] = {{"chorded", chorded}, {"rolling", rolling}, {"shortcut", shortcut}};
+
+static uint32_t latencies[MAX_EVENTS];
+
+int main(void) {
+    uint32_t bad = 0;
+
+    for (uint8_t s = 0; s < ARRAY_SIZE(streams); s++) {
+        start();
+        streams[s].run();
+        idle(100);
+
+        uint32_t found = 0, lost = 0;
+        for (uint32_t i = 0; i < event_count; i++) {
+            uint32_t r = events[i].reports_before;
+            while (r < sent_count && shows(&sent[r], events[i].code) != events[i].pressed) {
+                r++;
+            }
+            if (r == sent_count) {
+                lost++;
+                continue;
+            }
+            latencies[found++] = (uint32_t)(sent[r].at - events[i].at);
+        }
+        qsort(latencies, found, sizeof(latencies[0]), compare);
+
+        uint32_t saved = 0;
+#ifdef REPORT_COALESCE_ENABLE
+        const report_coalesce_stats_t *stats = report_coalesce_stats();
+        saved = stats->reports_in - stats->reports_out - saved_before;
+#endif
+        printf("%-10s %-9s %7u %8u %6u %7u %7u %9u %5u\n", PATH, streams[s].name, event_count, sent_count, saved, found ? latencies[found / 2] : 0, found ? latencies[found - 1] : 0, max_stall, lost);
+        bad += lost;
+    }
+    return bad ? 1 : 0;
+}
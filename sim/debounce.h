@@ -0,0 +1,9 @@
+#pragma once
+
+// QMK's debounce interface, see quantum/debounce.h.
+
+#include "quantum.h"
+
+bool debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed);
+void debounce_init(uint8_t num_rows);
+void debounce_free(void);
@@ -0,0 +1,204 @@
+// Press/release latency of the matrix debounce. Random keystrokes with
+// contact bounce on both edges are sampled at a fixed scan rate and run
+// through QMK's default sym_defer_g (modelled below) and through
+// debounce_eager.c. Latency is measured from the first contact edge to the
+// scan that changes the cooked matrix, i.e. to the report; every cooked
+// transition beyond one press and one release per keystroke is chatter.
+
+#include <stdio.h>
+#include <string.h>
+#include "debounce.h"
+
+#define KEYSTROKES 4000
+#define ROW 2
+#define COL 1
+#define MAX_EDGES 32
+
+#ifndef DEBOUNCE
+#    define DEBOUNCE 5
+#endif
+
+bool eager_debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed);
+void eager_debounce_init(uint8_t num_rows);
+
+static uint64_t now_us;
+
+uint16_t timer_read(void) {
+    return (uint16_t)(now_us / 1000);
+}
+
+uint32_t timer_read32(void) {
+    return (uint32_t)(now_us / 1000);
+}
+
+uint16_t timer_elapsed(uint16_t last) {
+    return (uint16_t)(timer_read() - last);
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return timer_read32() - last;
+}
+
+fast_timer_t timer_read_fast(void) {
+    return timer_read32();
+}
+
+fast_timer_t timer_elapsed_fast(fast_timer_t last) {
+    return timer_read_fast() - last;
+}
+
+// quantum/debounce/sym_defer_g.c
+static bool         ref_debouncing = false;
+static fast_timer_t ref_time;
+
+static void ref_debounce_init(uint8_t num_rows) {
+    (void)num_rows;
+    ref_debouncing = false;
+}
+
+static bool ref_debounce(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed) {
+    bool cooked_changed = false;
+
+    if (changed) {
+        ref_debouncing = true;
+        ref_time       = timer_read_fast();
+    } else if (ref_debouncing && timer_elapsed_fast(ref_time) >= DEBOUNCE) {
+        if (memcmp(cooked, raw, num_rows * sizeof(matrix_row_t)) != 0) {
+            memcpy(cooked, raw, num_rows * sizeof(matrix_row_t));
+            cooked_changed = true;
+        }
+        ref_debouncing = false;
+    }
+    return cooked_changed;
+}
+
+typedef struct {
+    const char *name;
+    void (*init)(uint8_t num_rows);
+    bool (*run)(matrix_row_t raw[], matrix_row_t cooked[], uint8_t num_rows, bool changed);
+} algorithm_t;
+
+typedef struct {
+    uint32_t edges[MAX_EDGES];
+    uint8_t  count;
+    uint32_t release;
+    uint32_t length;
+} keystroke_t;
+
+typedef struct {
+    double   press_sum;
+    uint32_t press_max;
+    double   release_sum;
+    uint32_t release_max;
+    uint32_t chatter;
+    uint32_t missed;
+} result_t;
+
+static uint32_t rng;
+
+static uint32_t random_between(uint32_t low, uint32_t high) {
+    rng = rng * 1664525u + 1013904223u;
+    return low + (rng >> 8) % (high - low + 1);
+}
+
+// Up to 2 ms of bounce: a few short opens (or closes) after the first edge.
+static void add_bounce(keystroke_t *k, uint32_t start) {
+    uint32_t t = start;
+
+    k->edges[k->count++] = t;
+    for (uint8_t i = random_between(0, 4); i > 0; i--) {
+        t += random_between(20, 400);
+        k->edges[k->count++] = t;
+        t += random_between(10, 100);
+        k->edges[k->count++] = t;
+    }
+}
+
+static void make_keystroke(keystroke_t *k) {
+    k->count = 0;
+    add_bounce(k, 0);
+    k->release = random_between(20000, 60000);
+    add_bounce(k, k->release);
+    k->length = k->release + random_between(20000, 60000);
+}
+
+static bool closed_at(const keystroke_t *k, uint32_t t) {
+    uint8_t edges = 0;
+
+    while (edges < k->count && k->edges[edges] <= t) {
+        edges++;
+    }
+    return edges & 1;
+}
+
+static result_t run(const algorithm_t *algo, uint32_t scan_us) {
+    matrix_row_t raw[MATRIX_ROWS]    = {0};
+    matrix_row_t cooked[MATRIX_ROWS] = {0};
+    result_t     result              = {0};
+    uint64_t     start               = 0;
+
+    rng    = 12345;
+    now_us = 0;
+    algo->init(MATRIX_ROWS);
+    for (uint32_t n = 0; n < KEYSTROKES; n++) {
+        keystroke_t k;
+        make_keystroke(&k);
+
+        // Scans keep their own cadence; the keystroke lands anywhere in it.
+        uint8_t  transitions = 0;
+        bool     pressed     = false;
+        bool     released    = false;
+        for (uint64_t scan = (start + scan_us - 1) / scan_us * scan_us; scan < start + k.length; scan += scan_us) {
+            uint32_t t = (uint32_t)(scan - start);
+            now_us     = scan;
+
+            matrix_row_t cols    = closed_at(&k, t) ? 1 << COL : 0;
+            bool         changed = raw[ROW] != cols;
+            raw[ROW]             = cols;
+            if (!algo->run(raw, cooked, MATRIX_ROWS, changed)) {
+                continue;
+            }
+            transitions++;
+            if (!pressed && (cooked[ROW] & (1 << COL))) {
+                pressed = true;
+                result.press_sum += t;
+                result.press_max = t > result.press_max ? t : result.press_max;
+            } else if (pressed && !released && !(cooked[ROW] & (1 << COL)) && t >= k.release) {
+                released = true;
+                result.release_sum += t - k.release;
+                result.release_max = t - k.release > result.release_max ? t - k.release : result.release_max;
+            }
+        }
+        start += k.length + random_between(0, 999);
+        if (!pressed || !released) {
+            result.missed++;
+        }
+        if (transitions > 2) {
+            result.chatter += transitions - 2;
+        }
+    }
+    return result;
+}
+
+int main(void) {
+    static const algorithm_t algorithms[] = {
+        {"sym_defer_g", ref_debounce_init, ref_debounce},
+        {"eager", eager_debounce_init, eager_debounce},
+    };
+    static const uint32_t scan_periods[] = {1000, 250, 25};
+    int                   failures       = 0;
+
+    printf("DEBOUNCE %d ms, %u keystrokes with 0-4 bounces per edge\n", DEBOUNCE, KEYSTROKES);
+    printf("%-12s %8s %10s %10s %10s %10s %8s %8s\n", "algorithm", "scan_us", "press_avg", "press_max", "rel_avg", "rel_max", "chatter", "missed");
+    for (uint8_t s = 0; s < sizeof(scan_periods) / sizeof(scan_periods[0]); s++) {
+        for (uint8_t a = 0; a < sizeof(algorithms) / sizeof(algorithms[0]); a++) {
+            result_t r = run(&algorithms[a], scan_periods[s]);
+
+            printf("%-12s %8u %8.0fus %8uus %8.0fus %8uus %8u %8u\n", algorithms[a].name, scan_periods[s], r.press_sum / KEYSTROKES, r.press_max, r.release_sum / KEYSTROKES, r.release_max, r.chatter, r.missed);
+            if (r.chatter || r.missed) {
+                failures++;
+            }
+        }
+    }
+    return failures ? 1 : 0;
+}
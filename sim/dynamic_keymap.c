@@ -0,0 +1,130 @@
+// Dynamic keymap, EEPROM emulation and the keymap part of VIA's command
+// handler, shaped like the QMK path on the device: a keycode read is two
+// eeprom_read_byte() calls through the driver into the wear-leveling cache,
+// each in its own translation unit (noinline here), and every changed byte
+// written costs one wear-leveling flash write of SIM_FLASH_WRITE_US.
+
+#include <string.h>
+#include "sim.h"
+#include "dynamic_keymap.h"
+#include "keymap_introspection.h"
+#include "raw_hid.h"
+#include "via.h"
+
+#define KEYMAP_EEPROM_SIZE (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+
+static uint8_t eeprom[KEYMAP_EEPROM_SIZE];
+static bool    eeprom_valid;
+
+__attribute__((noinline)) static void wear_leveling_read(uint32_t address, void *value, size_t size) {
+    if (address + size <= sizeof(eeprom)) {
+        memcpy(value, &eeprom[address], size);
+    }
+}
+
+__attribute__((noinline)) static void eeprom_driver_read_block(void *buf, const void *addr, size_t len) {
+    wear_leveling_read((uint32_t)(uintptr_t)addr, buf, len);
+}
+
+__attribute__((noinline)) static uint8_t eeprom_read_byte(const uint8_t *addr) {
+    uint8_t ret = 0;
+    eeprom_driver_read_block(&ret, addr, 1);
+    return ret;
+}
+
+static void eeprom_update_byte(uint8_t *addr, uint8_t value) {
+    uint32_t address = (uint32_t)(uintptr_t)addr;
+    if (address < sizeof(eeprom) && eeprom[address] != value) {
+        eeprom[address] = value;
+        sim_stats.flash_writes++;
+        sim_advance_us(SIM_FLASH_WRITE_US);
+    }
+}
+
+static uint8_t *keycode_address(uint8_t layer, uint8_t row, uint8_t col) {
+    return (uint8_t *)(uintptr_t)((layer * MATRIX_ROWS * MATRIX_COLS + row * MATRIX_COLS + col) * 2);
+}
+
+uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t col) {
+    if (layer >= DYNAMIC_KEYMAP_LAYER_COUNT || row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+        return KC_NO;
+    }
+    uint8_t *address = keycode_address(layer, row, col);
+    return eeprom_read_byte(address) << 8 | eeprom_read_byte(address + 1);
+}
+
+void dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t col, uint16_t keycode) {
+    if (layer >= DYNAMIC_KEYMAP_LAYER_COUNT || row >= MATRIX_ROWS || col >= MATRIX_COLS) {
+        return;
+    }
+    uint8_t *address = keycode_address(layer, row, col);
+    eeprom_update_byte(address, keycode >> 8);
+    eeprom_update_byte(address + 1, keycode & 0xFF);
+}
+
+void dynamic_keymap_reset(void) {
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                dynamic_keymap_set_keycode(layer, row, col, layer < keymap_layer_count() ? keycode_at_keymap_location_raw(layer, row, col) : KC_TRANSPARENT);
+            }
+        }
+    }
+}
+
+void dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, const uint8_t *data) {
+    for (uint16_t i = 0; i < size; i++) {
+        eeprom_update_byte((uint8_t *)(uintptr_t)(offset + i), data[i]);
+    }
+}
+
+// VIA's part of an EEPROM reset.
+void eeconfig_init_via(void) {
+    dynamic_keymap_reset();
+}
+
+// eeconfig_init_quantum(), as run by EE_CLR: the dynamic keymap, then the
+// keyboard's hook.
+void eeconfig_init(void) {
+    dynamic_keymap_reset();
+    eeconfig_init_kb();
+}
+
+// The keymap is only written on the first boot; later boots find it valid.
+void via_init(void) {
+    if (!eeprom_valid) {
+        dynamic_keymap_reset();
+        eeprom_valid = true;
+    }
+}
+
+void raw_hid_receive(uint8_t *data, uint8_t length) {
+    if (via_command_kb(data, length)) {
+        return;
+    }
+
+    switch (data[0]) {
+        case id_dynamic_keymap_get_keycode: {
+            uint16_t keycode = dynamic_keymap_get_keycode(data[1], data[2], data[3]);
+            data[4]          = keycode >> 8;
+            data[5]          = keycode & 0xFF;
+            break;
+        }
+        case id_dynamic_keymap_set_keycode:
+            dynamic_keymap_set_keycode(data[1], data[2], data[3], data[4] << 8 | data[5]);
+            break;
+        case id_dynamic_keymap_reset:
+            dynamic_keymap_reset();
+            break;
+        case id_dynamic_keymap_set_buffer:
+            dynamic_keymap_set_buffer(data[1] << 8 | data[2], data[3], &data[4]);
+            break;
+        case id_eeprom_reset:
+            eeconfig_init_via();
+            break;
+        default:
+            data[0] = id_unhandled;
+            break;
+    }
+    raw_hid_send(data, length);
+}
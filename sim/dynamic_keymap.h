@@ -0,0 +1,8 @@
+#pragma once
+
+#include <stdint.h>
+
+uint16_t dynamic_keymap_get_keycode(uint8_t layer, uint8_t row, uint8_t col);
+void     dynamic_keymap_set_keycode(uint8_t layer, uint8_t row, uint8_t col, uint16_t keycode);
+void     dynamic_keymap_reset(void);
+void     dynamic_keymap_set_buffer(uint16_t offset, uint16_t size, const uint8_t *data);
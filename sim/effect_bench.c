@@ -0,0 +1,107 @@
+// Per-layer effect engine: host cost of one frame of each layer's effect,
+// checked for the RGBLIGHT_LIMIT_VAL cap and for frames that depend on
+// anything but their inputs. Then runs the engine in RGB_EFFECT_MODE_LAYER
+// for a simulated second per layer and counts the frames it pushes, and
+// checks that a suspend blanks the strip without waiting for the main loop.
+//   make effects
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+#include "rgb_effect.h"
+#include "rgb_state.h"
+
+#define LAYERS 5
+#define FRAMES 20000
+#define SCAN_US 1000
+#define RUN_MS 1000
+
+static uint64_t wall_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint8_t brightest(const rgb_effect_led_t *leds) {
+    uint8_t max = 0;
+
+    for (uint8_t i = 0; i < RGBLIGHT_LED_COUNT; i++) {
+        max = MAX(max, MAX(leds[i].r, MAX(leds[i].g, leds[i].b)));
+    }
+    return max;
+}
+
+// Full brightness in, so the cap is what limits the output.
+static uint32_t check_layer(uint8_t layer, double *frame_ns) {
+    rgb_effect_led_t leds[RGBLIGHT_LED_COUNT];
+    rgb_effect_led_t again[RGBLIGHT_LED_COUNT];
+    uint32_t         bad = 0;
+
+    for (uint32_t ms = 0; ms < FRAMES; ms += 7) {
+        rgb_effect_render(layer, rgb_layer_hue(layer), 255, 255, ms, leds, RGBLIGHT_LED_COUNT);
+        rgb_effect_render(layer, rgb_layer_hue(layer), 255, 255, ms, again, RGBLIGHT_LED_COUNT);
+        bad += brightest(leds) > RGBLIGHT_LIMIT_VAL;
+        bad += memcmp(leds, again, sizeof(leds)) != 0;
+    }
+
+    volatile uint8_t sink  = 0;
+    uint64_t         start = wall_ns();
+    for (uint32_t ms = 0; ms < FRAMES; ms++) {
+        rgb_effect_render(layer, rgb_layer_hue(layer), 255, RGBLIGHT_LIMIT_VAL, ms * RGB_EFFECT_FRAME_MS, leds, RGBLIGHT_LED_COUNT);
+        sink += leds[0].r;
+    }
+    *frame_ns = (double)(wall_ns() - start) / FRAMES;
+    return bad;
+}
+
+static void run_for(uint32_t ms) {
+    for (uint32_t i = 0; i < ms * 1000 / SCAN_US; i++) {
+        sim_advance_us(SCAN_US);
+        sim_scan();
+    }
+}
+
+// The keymap requests its own mode on a layer change, so ask for the
+// engine after it.
+static void show_layer(uint8_t layer) {
+    layer_move(layer);
+    rgb_state_request(true, RGB_EFFECT_MODE_LAYER, rgb_layer_hue(layer), 255, RGBLIGHT_LIMIT_VAL);
+    run_for(RGB_STATE_REFRESH_MS);
+}
+
+// Frames the engine pushes in RUN_MS on this layer.
+static uint32_t engine_frames(uint8_t layer) {
+    show_layer(layer);
+    sim_reset_stats();
+    run_for(RUN_MS);
+    return sim_stats.led_frames;
+}
+
+static uint32_t check_suspend(void) {
+    uint32_t bad = 0;
+
+    show_layer(1);
+    bad += sim_strip_lit() == 0;
+    suspend_power_down_kb();
+    bad += sim_strip_lit() != 0;
+    suspend_wakeup_init_kb();
+    bad += sim_strip_lit() == 0;
+    return bad;
+}
+
+int main(void) {
+    uint32_t bad = 0;
+
+    sim_init();
+    printf("%-6s %-10s %10s %12s\n", "layer", "animated", "frame_ns", "frames_per_s");
+    for (uint8_t layer = 0; layer < LAYERS; layer++) {
+        double frame_ns;
+        bad += check_layer(layer, &frame_ns);
+        printf("%-6u %-10s %10.1f %12u\n", layer, rgb_effect_animated(layer) ? "yes" : "no", frame_ns, engine_frames(layer));
+    }
+    bad += check_suspend();
+
+    printf("failures %u\n", bad);
+    return bad ? 1 : 0;
+}
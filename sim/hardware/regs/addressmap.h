@@ -0,0 +1,9 @@
+#pragma once
+
+#include <stdint.h>
+
+// Flash is an array that harnesses fill; XIP reads go straight to it.
+#define SIM_FLASH_SIZE (2 * 1024 * 1024)
+
+extern uint8_t sim_flash[SIM_FLASH_SIZE];
+#define XIP_BASE ((uintptr_t)sim_flash)
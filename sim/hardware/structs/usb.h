@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+
+// Only the frame number, which follows the simulator clock: one frame per
+// SIM_USB_POLL_US.
+typedef struct {
+    uint32_t sof_rd;
+} usb_hw_t;
+
+#define USB_SOF_RD_BITS 0x000007ff
+
+usb_hw_t *sim_usb_hw(void);
+#define usb_hw (sim_usb_hw())
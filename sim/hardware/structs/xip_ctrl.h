@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+
+// The simulator has no XIP cache; the counters just read back what was last
+// written.
+typedef struct {
+    uint32_t ctr_hit;
+    uint32_t ctr_acc;
+} xip_ctrl_hw_t;
+
+extern xip_ctrl_hw_t sim_xip_ctrl;
+#define xip_ctrl_hw (&sim_xip_ctrl)
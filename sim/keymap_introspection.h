@@ -0,0 +1,6 @@
+#pragma once
+
+#include <stdint.h>
+
+uint8_t  keymap_layer_count(void);
+uint16_t keycode_at_keymap_location_raw(uint8_t layer, uint8_t row, uint8_t col);
@@ -0,0 +1,186 @@
+// Keycode lookup and VIA write cost of the via keymap, built once on QMK's
+// EEPROM path and once with keymap_cache.c (-DKEYMAP_CACHE):
+//   make keymap
+// Lookup times are host ns, only good for comparing the two
+// builds. VIA write times add the modeled flash stall of every changed byte
+// to the host time of the packet; the worst case is a full 28-byte
+// set_buffer chunk. Afterwards random VIA writes, VIA EEPROM resets and
+// EE_CLR-style eeconfig_init() calls check the lookups still agree with the
+// EEPROM copy.
+
+#include <stdio.h>
+#include <time.h>
+#include "sim.h"
+#include "dynamic_keymap.h"
+#include "raw_hid.h"
+#include "via.h"
+
+#define LOOKUP_REPEAT 20000
+#define WRITE_REPEAT 200
+#define CHECK_WRITES 5000
+#define PACKET 32
+#define BUFFER_CHUNK 28
+#define KEYMAP_BYTES (DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS * 2)
+
+#ifdef KEYMAP_CACHE
+#    define PATH "sram cache"
+#else
+#    define PATH "eeprom"
+#    include "keymap_cache.h"
+
+// Stock build: the keyboard hooks find nothing to mirror.
+void keymap_cache_init(void) {}
+
+void keymap_cache_via_command(const uint8_t *data, uint8_t length) {
+    (void)data;
+    (void)length;
+}
+
+void keymap_cache_reload(void) {}
+
+void keymap_cache_set_layers(layer_state_t state) {
+    (void)state;
+}
+
+void keymap_cache_process(uint16_t keycode, const keyrecord_t *record) {
+    (void)keycode;
+    (void)record;
+}
+#endif
+
+static uint32_t rng = 1;
+
+static uint32_t next_random(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 8;
+}
+
+static uint64_t wall_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+void raw_hid_send(uint8_t *data, uint8_t length) {
+    (void)data;
+    (void)length;
+}
+
+static double lookup_ns(void) {
+    volatile uint16_t sink = 0;
+    uint64_t          start = wall_ns();
+
+    for (uint32_t i = 0; i < LOOKUP_REPEAT; i++) {
+        for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+            for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+                for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                    sink += keymap_key_to_keycode(layer, (keypos_t){.col = col, .row = row});
+                }
+            }
+        }
+    }
+    return (double)(wall_ns() - start) / ((double)LOOKUP_REPEAT * DYNAMIC_KEYMAP_LAYER_COUNT * MATRIX_ROWS * MATRIX_COLS);
+}
+
+// Returns host ns plus modeled flash us (as ns) of one packet.
+static uint64_t send(uint8_t *packet) {
+    uint64_t sim_start = sim_now_us();
+    uint64_t start     = wall_ns();
+    raw_hid_receive(packet, PACKET);
+    return wall_ns() - start + (sim_now_us() - sim_start) * 1000;
+}
+
+static void set_keycode_packet(uint8_t *packet, uint8_t layer, uint8_t row, uint8_t col, uint16_t keycode) {
+    packet[0] = id_dynamic_keymap_set_keycode;
+    packet[1] = layer;
+    packet[2] = row;
+    packet[3] = col;
+    packet[4] = keycode >> 8;
+    packet[5] = keycode & 0xFF;
+}
+
+static void set_buffer_packet(uint8_t *packet, uint16_t offset, uint8_t size) {
+    packet[0] = id_dynamic_keymap_set_buffer;
+    packet[1] = offset >> 8;
+    packet[2] = offset & 0xFF;
+    packet[3] = size;
+    for (uint8_t i = 0; i < size; i++) {
+        packet[4 + i] = next_random();
+    }
+}
+
+// Worst case of each write kind: every byte it touches changes.
+static void write_latency(double *keycode_us, double *buffer_us) {
+    uint64_t keycode_max = 0;
+    uint64_t buffer_max  = 0;
+
+    for (uint32_t i = 0; i < WRITE_REPEAT; i++) {
+        uint8_t  packet[PACKET] = {0};
+        uint16_t current        = dynamic_keymap_get_keycode(1, 2, 3);
+        set_keycode_packet(packet, 1, 2, 3, ~current);
+        uint64_t keycode_ns = send(packet);
+        keycode_max         = MAX(keycode_max, keycode_ns);
+
+        uint8_t buffer[PACKET] = {0};
+        set_buffer_packet(buffer, (i * BUFFER_CHUNK) % (KEYMAP_BYTES - BUFFER_CHUNK), BUFFER_CHUNK);
+        uint64_t buffer_ns = send(buffer);
+        buffer_max         = MAX(buffer_max, buffer_ns);
+    }
+    *keycode_us = keycode_max / 1000.0;
+    *buffer_us  = buffer_max / 1000.0;
+}
+
+static uint32_t mismatches(void) {
+    uint32_t bad = 0;
+
+    for (uint8_t layer = 0; layer < DYNAMIC_KEYMAP_LAYER_COUNT; layer++) {
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                bad += keymap_key_to_keycode(layer, (keypos_t){.col = col, .row = row}) != dynamic_keymap_get_keycode(layer, row, col);
+            }
+        }
+    }
+    return bad;
+}
+
+// Random keycode and buffer writes, odd offsets and lengths included, with
+// the occasional keymap reset, VIA EEPROM reset or eeconfig_init(); compared
+// after every one.
+static uint32_t check(void) {
+    uint32_t bad = 0;
+
+    for (uint32_t i = 0; i < CHECK_WRITES; i++) {
+        uint8_t  packet[PACKET] = {0};
+        uint32_t kind           = next_random() % 64;
+
+        if (kind == 4) {
+            eeconfig_init();
+            bad += mismatches();
+            continue;
+        }
+        if (kind == 0) {
+            packet[0] = id_dynamic_keymap_reset;
+        } else if (kind == 2) {
+            packet[0] = id_eeprom_reset;
+        } else if (kind & 1) {
+            set_keycode_packet(packet, next_random() % (DYNAMIC_KEYMAP_LAYER_COUNT + 1), next_random() % (MATRIX_ROWS + 1), next_random() % MATRIX_COLS, next_random());
+        } else {
+            set_buffer_packet(packet, next_random() % (KEYMAP_BYTES + 8), next_random() % (BUFFER_CHUNK + 1));
+        }
+        raw_hid_receive(packet, PACKET);
+        bad += mismatches();
+    }
+    return bad;
+}
+
+int main(void) {
+    double keycode_us, buffer_us;
+
+    sim_init();
+    double lookup = lookup_ns();
+    write_latency(&keycode_us, &buffer_us);
+    uint32_t bad = check();
+
+    printf("%-12s %12.2f %14.1f %14.1f %10u\n", PATH, lookup, keycode_us, buffer_us, bad);
+    return bad ? 1 : 0;
+}
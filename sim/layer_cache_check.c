@@ -0,0 +1,224 @@
+// Checks the effective-keycode table in keymap_cache.c against a reference
+// layer walk over the keymap itself, for every layer combination of layers
+// 0-4: each default layer with each of the 32 layer_state masks, reached
+// from every other combination so the incremental update sees every
+// possible set of changed layers. QMK's own walk (layer_switch_get_layer())
+// goes through keymap_key_to_keycode() and must find the reference keycode
+// with one lookup. Every key is also pressed before each transition and
+// released after it, and must release the keycode it pressed, as QMK's
+// source-layer cache would have it. The dynamic keymap builds repeat the
+// check after random VIA keymap writes.
+//   make layers
+
+#include <stdio.h>
+#include <time.h>
+#include "sim.h"
+#include "keymap_cache.h"
+#include "keymap_introspection.h"
+#ifdef DYNAMIC_KEYMAP_ENABLE
+#    include "dynamic_keymap.h"
+#    include "raw_hid.h"
+#    include "via.h"
+#endif
+
+#define LAYERS 5
+#define STATES (LAYERS << LAYERS)
+#define VIA_ROUNDS 200
+#define TIMING_REPEAT 2000
+#define PACKET 32
+
+typedef struct {
+    layer_state_t default_layers;
+    layer_state_t layers;
+} combo_t;
+
+static uint32_t lookups;
+
+static uint64_t wall_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static combo_t combo(uint16_t index) {
+    return (combo_t){.default_layers = (layer_state_t)1 << (index >> LAYERS), .layers = index & ((1 << LAYERS) - 1)};
+}
+
+static void enter(combo_t c) {
+    default_layer_set(c.default_layers);
+    layer_state_set(c.layers);
+}
+
+// The keymap as stored, without the table.
+static uint16_t stored(uint8_t layer, keypos_t key) {
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    return dynamic_keymap_get_keycode(layer, key.row, key.col);
+#else
+    return keycode_at_keymap_location_raw(layer, key.row, key.col);
+#endif
+}
+
+// The layer walk on the stored keymap.
+static uint16_t reference(keypos_t key) {
+    layer_state_t layers = layer_state | default_layer_state;
+
+    for (int8_t i = MAX_LAYER - 1; i >= 0; i--) {
+        if ((layers & ((layer_state_t)1 << i)) && stored(i, key) != KC_TRNS) {
+            return stored(i, key);
+        }
+    }
+    return stored(0, key);
+}
+
+// layer_switch_get_layer() from action_layer.c, counting lookups.
+static uint8_t walk(keypos_t key) {
+    layer_state_t layers = layer_state | default_layer_state;
+
+    for (int8_t i = MAX_LAYER - 1; i >= 0; i--) {
+        if (layers & ((layer_state_t)1 << i)) {
+            lookups++;
+            if (keymap_key_to_keycode(i, key) != KC_TRNS) {
+                return (uint8_t)i;
+            }
+        }
+    }
+    return 0;
+}
+
+// What QMK's press path sends, checked against the reference.
+static uint16_t press(keypos_t key, uint8_t *layer, uint32_t *bad) {
+    lookups = 0;
+    *layer           = walk(key);
+    uint16_t keycode = keymap_key_to_keycode(*layer, key);
+    *bad += keycode != reference(key) || (keycode != KC_TRNS && lookups != 1);
+    return keycode;
+}
+
+static uint32_t mismatches(void) {
+    uint32_t bad = 0;
+    uint8_t  layer;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            press((keypos_t){.col = col, .row = row}, &layer, &bad);
+        }
+    }
+    return bad;
+}
+
+// Presses every key in from, moves to to and releases them all.
+static uint32_t held_across(combo_t from, combo_t to) {
+    uint32_t bad = 0;
+    uint8_t  layer[MATRIX_ROWS][MATRIX_COLS];
+    uint16_t keycode[MATRIX_ROWS][MATRIX_COLS];
+
+    enter(from);
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            keyrecord_t record = {.event = {.key = {.col = col, .row = row}, .pressed = true}};
+            keycode[row][col]  = press(record.event.key, &layer[row][col], &bad);
+            keymap_cache_process(keycode[row][col], &record);
+        }
+    }
+    enter(to);
+    bad += mismatches();
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            keyrecord_t record  = {.event = {.key = {.col = col, .row = row}, .pressed = false}};
+            uint16_t    release = keymap_key_to_keycode(layer[row][col], record.event.key);
+            bad += release != keycode[row][col];
+            keymap_cache_process(release, &record);
+        }
+    }
+    return bad;
+}
+
+static uint32_t check_transitions(void) {
+    uint32_t bad = 0;
+
+    for (uint16_t from = 0; from < STATES; from++) {
+        for (uint16_t to = 0; to < STATES; to++) {
+            bad += held_across(combo(from), combo(to));
+        }
+    }
+    return bad;
+}
+
+#ifdef DYNAMIC_KEYMAP_ENABLE
+static uint32_t rng = 1;
+
+static uint32_t next_random(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 8;
+}
+
+// Mostly KC_TRNS so that layers fall through in new ways.
+static void random_keymap_write(void) {
+    uint8_t  packet[PACKET] = {id_dynamic_keymap_set_keycode, next_random() % LAYERS, next_random() % MATRIX_ROWS, next_random() % MATRIX_COLS};
+    uint16_t keycode        = next_random() % 3 ? KC_TRNS : KC_A + next_random() % 32;
+
+    packet[4] = keycode >> 8;
+    packet[5] = keycode & 0xFF;
+    raw_hid_receive(packet, PACKET);
+}
+
+static uint32_t check_via_writes(void) {
+    uint32_t bad = 0;
+
+    for (uint32_t round = 0; round < VIA_ROUNDS; round++) {
+        enter(combo(next_random() % STATES));
+        random_keymap_write();
+        bad += mismatches();
+        for (uint16_t index = 0; index < STATES; index++) {
+            enter(combo(index));
+            bad += mismatches();
+        }
+    }
+    return bad;
+}
+#endif
+
+// ns per key press, the reference walk on the stored keymap vs QMK's walk
+// and lookup through the table, over every combination.
+static void timing(double *walk_ns, double *cache_ns) {
+    volatile uint16_t sink  = 0;
+    uint64_t          spent = 0;
+    uint64_t          taken = 0;
+    uint32_t          n     = 0;
+
+    for (uint32_t i = 0; i < TIMING_REPEAT; i++) {
+        enter(combo(i % STATES));
+        uint64_t start = wall_ns();
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                sink += reference((keypos_t){.col = col, .row = row});
+            }
+        }
+        uint64_t middle = wall_ns();
+        for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+            for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+                keypos_t key = {.col = col, .row = row};
+                sink += keymap_key_to_keycode(walk(key), key);
+            }
+        }
+        spent += middle - start;
+        taken += wall_ns() - middle;
+        n += MATRIX_ROWS * MATRIX_COLS;
+    }
+    *walk_ns  = (double)spent / n;
+    *cache_ns = (double)taken / n;
+}
+
+int main(void) {
+    double walk_ns, cache_ns;
+
+    sim_init();
+    uint32_t bad = mismatches() + check_transitions();
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    bad += check_via_writes();
+#endif
+    timing(&walk_ns, &cache_ns);
+
+    printf("%-8s %8u %12.2f %12.2f %10u\n", SIM_KEYMAP, STATES, walk_ns, cache_ns, bad);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,214 @@
+// Raw HID LED streaming (rgb_stream.c) in a loopback: a host app renders
+// frames at a fixed rate and writes each as two packets; the raw HID OUT
+// endpoint moves one packet per 1 ms frame into a RAW_OUT_CAPACITY deep
+// queue (NAKing while it is full), and the main loop drains the queue every
+// scan as raw_hid_task() does. Meanwhile keys are typed, and their
+// scan-to-report latency is compared with a run without streaming. A lossy
+// run drops packets on the way to check the drop counter. Checks that every
+// frame is shown when nothing is lost, that the strip ends up with the last
+// frame's colours, and that the strip goes back to rgblight after
+// RGB_STREAM_TIMEOUT_MS.
+//   make stream
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "host_cmd.h"
+#include "raw_hid.h"
+#include "rgb_stream.h"
+
+#define SCAN_US 100
+#define RUN_MS 5000
+#define PACKET 32
+#define RAW_OUT_CAPACITY 4
+#define MAX_PACKETS 8192
+#define MAX_KEYS 1024
+
+typedef struct {
+    uint8_t data[PACKET];
+    bool    lost;
+} packet_t;
+
+typedef struct {
+    uint16_t fps;
+    uint16_t loss_per_mille;
+} run_t;
+
+static const run_t runs[] = {{0, 0}, {100, 0}, {250, 0}, {500, 0}, {100, 10}};
+
+static packet_t  host_queue[MAX_PACKETS];
+static uint32_t  host_head, host_tail;
+static packet_t  endpoint[RAW_OUT_CAPACITY];
+static uint8_t   endpoint_count;
+static uint64_t  next_bus_at;
+static uint32_t  expected_drops;
+static bool      last_show_lost;
+static uint8_t   last_colour[RGBLIGHT_LED_COUNT][3];
+static uint32_t  rng = 11;
+
+static host_driver_t *sim_driver;
+static host_driver_t  capture;
+static uint64_t       key_at;
+static bool           key_pending;
+static uint32_t       key_latency[MAX_KEYS];
+static uint32_t       key_count;
+
+static uint32_t next_random(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 8;
+}
+
+static void capture_keyboard(report_keyboard_t *report) {
+    sim_driver->send_keyboard(report);
+    if (key_pending && key_count < MAX_KEYS) {
+        key_latency[key_count++] = (uint32_t)(sim_now_us() - key_at);
+    }
+    key_pending = false;
+}
+
+static void queue_packet(uint8_t frame, uint8_t first, uint8_t count, bool show, uint16_t loss_per_mille) {
+    packet_t *packet = &host_queue[host_head++ % MAX_PACKETS];
+
+    memset(packet, 0, sizeof(*packet));
+    packet->data[0] = HOST_CMD_ID;
+    packet->data[1] = HOST_CMD_LED_FRAME;
+    packet->data[2] = frame;
+    packet->data[3] = first;
+    packet->data[4] = count | (show ? RGB_STREAM_SHOW : 0);
+    for (uint8_t i = 0; i < count; i++) {
+        memcpy(&packet->data[5 + i * 3], last_colour[first + i], 3);
+    }
+    packet->lost = next_random() % 1000 < loss_per_mille;
+    // The frame before a lost show packet stays on the strip.
+    if (show) {
+        expected_drops += packet->lost;
+        last_show_lost = packet->lost;
+    }
+}
+
+static void render_frame(uint8_t frame, uint16_t loss_per_mille) {
+    for (uint8_t i = 0; i < RGBLIGHT_LED_COUNT; i++) {
+        last_colour[i][0] = frame + i * 25;
+        last_colour[i][1] = 255 - frame;
+        last_colour[i][2] = i * 20 + (frame & 1);
+    }
+    for (uint8_t first = 0; first < RGBLIGHT_LED_COUNT; first += RGB_STREAM_LEDS_PER_PACKET) {
+        uint8_t count = MIN(RGB_STREAM_LEDS_PER_PACKET, RGBLIGHT_LED_COUNT - first);
+        queue_packet(frame, first, count, first + count == RGBLIGHT_LED_COUNT, loss_per_mille);
+    }
+}
+
+// One transfer per bus frame while the endpoint has room.
+static void bus(void) {
+    while (next_bus_at <= sim_now_us()) {
+        next_bus_at += SIM_USB_POLL_US;
+        if (host_tail == host_head || endpoint_count == RAW_OUT_CAPACITY) {
+            continue;
+        }
+        packet_t *packet = &host_queue[host_tail++ % MAX_PACKETS];
+        if (!packet->lost) {
+            endpoint[endpoint_count++] = *packet;
+        }
+    }
+}
+
+static void raw_hid_task(void) {
+    for (uint8_t i = 0; i < endpoint_count; i++) {
+        raw_hid_receive(endpoint[i].data, PACKET);
+    }
+    endpoint_count = 0;
+}
+
+static int compare(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+int main(void) {
+    uint32_t bad = 0;
+
+    printf("%5s %6s %7s %7s %7s %8s %8s %10s %10s %9s\n", "fps", "loss%", "sent", "shown", "fps_out", "dropped", "expected", "key_p50_us", "key_max_us", "stall_us");
+    for (uint8_t r = 0; r < ARRAY_SIZE(runs); r++) {
+        const run_t *run = &runs[r];
+
+        sim_init();
+        sim_driver            = host_get_driver();
+        capture               = *sim_driver;
+        capture.send_keyboard = capture_keyboard;
+        host_set_driver(&capture);
+        sim_scan();
+
+        const rgb_stream_stats_t before = *rgb_stream_stats();
+        host_head = host_tail = 0;
+        endpoint_count        = 0;
+        next_bus_at           = 0;
+        expected_drops        = 0;
+        last_show_lost        = false;
+        key_count             = 0;
+        key_pending           = false;
+
+        uint32_t frames = 0, max_stall = 0;
+        uint64_t next_frame = 0, next_key = 3000, end = (uint64_t)RUN_MS * 1000;
+        bool     held       = false;
+
+        while (sim_now_us() < end) {
+            uint64_t at = sim_now_us();
+
+            if (run->fps && at >= next_frame) {
+                render_frame(frames++, run->loss_per_mille);
+                next_frame += 1000000 / run->fps;
+            }
+            bus();
+            if (at >= next_key) {
+                held        = !held;
+                key_at      = at;
+                key_pending = true;
+                sim_key(4, 0, held);
+                next_key    = at + 20000 + next_random() % 60000;
+            }
+            raw_hid_task();
+            sim_scan();
+            max_stall = MAX(max_stall, (uint32_t)(sim_now_us() - at));
+            sim_advance_us(SCAN_US);
+        }
+        // Let the endpoint drain.
+        for (uint16_t i = 0; i < 100; i++) {
+            bus();
+            raw_hid_task();
+            sim_scan();
+            sim_advance_us(SCAN_US);
+        }
+
+        // A lost last frame is never followed by one that shows the gap.
+        expected_drops -= last_show_lost;
+
+        const rgb_stream_stats_t *stats   = rgb_stream_stats();
+        uint32_t                  shown   = stats->frames - before.frames;
+        uint32_t                  dropped = stats->dropped - before.dropped;
+        bool                      colours = true;
+        for (uint8_t i = 0; i < RGBLIGHT_LED_COUNT && frames; i++) {
+            colours &= memcmp(sim_strip_led(i), last_colour[i], 3) == 0;
+        }
+        if (run->fps) {
+            bad += dropped != expected_drops;
+            bad += !run->loss_per_mille && (shown != frames || !colours);
+            bad += stats->rejected != 0;
+        }
+
+        // Handed back once the frames stop.
+        uint32_t rgb_calls = sim_stats.rgb_calls;
+        for (uint32_t i = 0; i < (RGB_STREAM_TIMEOUT_MS + 100) * 1000 / SCAN_US; i++) {
+            sim_scan();
+            sim_advance_us(SCAN_US);
+        }
+        bad += rgb_stream_active() || (run->fps && sim_stats.rgb_calls == rgb_calls);
+
+        qsort(key_latency, key_count, sizeof(key_latency[0]), compare);
+        printf("%5u %6.1f %7u %7u %7.1f %8u %8u %10u %10u %9u\n", run->fps, run->loss_per_mille / 10.0, frames, shown, shown * 1000.0 / RUN_MS, dropped, expected_drops, key_count ? key_latency[key_count / 2] : 0, key_count ? key_latency[key_count - 1] : 0, max_stall);
+    }
+    if (bad) {
+        fprintf(stderr, "%u checks failed\n", bad);
+    }
+    return bad ? 1 : 0;
+}
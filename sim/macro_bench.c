@@ -0,0 +1,115 @@
+// Scan gaps while a macro plays: the duplicate-line sequence of layer 1 sent
+// with tap_code16() from the key event, as QMK macros do, against the same
+// sequence queued with macro_seq_play(), and once more through the keymap
+// key that plays it. The report streams must be identical.
+//   make macro
+
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "macro_seq.h"
+
+#define SCAN_US 100
+#define SCANS 400
+#define TRIGGER 10
+#define MAX_REPORTS 64
+
+// Layer 1, row 1, col 2 of every keymap.
+#define DUP_LINE_ROW 1
+#define DUP_LINE_COL 2
+
+static const macro_step_t dup_line[] = {
+    SEQ_TAP(KC_HOME), SEQ_TAP(S(KC_END)), SEQ_TAP(LCTL(KC_C)), SEQ_TAP(KC_END), SEQ_TAP(KC_ENT), SEQ_TAP(LCTL(KC_V)),
+};
+
+typedef enum {
+    PLAY_TAP_CODE,
+    PLAY_SEQUENCER,
+    PLAY_KEYMAP,
+} play_t;
+
+typedef struct {
+    report_keyboard_t reports[MAX_REPORTS];
+    uint8_t           count;
+    uint64_t          last_at;
+    uint64_t          max_gap;
+    uint64_t          played_us;
+} run_t;
+
+static run_t          *recording;
+static host_driver_t  *sim_driver;
+static host_driver_t   capture;
+
+static void capture_keyboard(report_keyboard_t *report) {
+    sim_driver->send_keyboard(report);
+    if (recording->count < MAX_REPORTS) {
+        recording->reports[recording->count++] = *report;
+    }
+    recording->last_at = sim_now_us();
+}
+
+static void trigger(play_t play) {
+    switch (play) {
+        case PLAY_TAP_CODE:
+            for (uint8_t i = 0; i < ARRAY_SIZE(dup_line); i++) {
+                tap_code16(dup_line[i].keycode);
+            }
+            break;
+        case PLAY_SEQUENCER:
+            macro_seq_play(dup_line, ARRAY_SIZE(dup_line));
+            break;
+        case PLAY_KEYMAP:
+            sim_key(DUP_LINE_ROW, DUP_LINE_COL, true);
+            break;
+    }
+}
+
+static void run(play_t play, run_t *result) {
+    uint64_t last_scan = 0;
+    uint64_t start     = 0;
+
+    sim_init();
+    layer_move(1);
+    sim_driver = host_get_driver();
+    capture    = *sim_driver;
+    capture.send_keyboard = capture_keyboard;
+    host_set_driver(&capture);
+    memset(result, 0, sizeof(*result));
+    recording = result;
+
+    for (uint32_t i = 0; i < SCANS; i++) {
+        uint64_t now = sim_now_us();
+        if (i > 0) {
+            result->max_gap = MAX(result->max_gap, now - last_scan);
+        }
+        last_scan = now;
+
+        if (i == TRIGGER) {
+            start = now;
+            trigger(play);
+        } else if (i == TRIGGER + 1 && play == PLAY_KEYMAP) {
+            sim_key(DUP_LINE_ROW, DUP_LINE_COL, false);
+        }
+        sim_advance_us(SCAN_US);
+        sim_scan();
+    }
+    result->played_us = result->last_at - start;
+    host_set_driver(sim_driver);
+}
+
+int main(void) {
+    static const char *names[] = {"tap_code16", "macro_seq", "keymap_key"};
+    run_t              runs[3];
+    uint32_t           bad = 0;
+
+    printf("%-12s %8s %12s %10s\n", "path", "reports", "max_gap_us", "played_us");
+    for (uint8_t play = 0; play < ARRAY_SIZE(runs); play++) {
+        run(play, &runs[play]);
+        printf("%-12s %8u %12llu %10llu\n", names[play], runs[play].count, (unsigned long long)runs[play].max_gap, (unsigned long long)runs[play].played_us);
+        bad += runs[play].count != runs[0].count || memcmp(runs[play].reports, runs[0].reports, sizeof(runs[0].reports)) != 0;
+    }
+    bad += macro_seq_busy();
+
+    printf("mismatches %u\n", bad);
+    return bad ? 1 : 0;
+}
@@ -0,0 +1,191 @@
+// Mouse key movement (mouse_motion.c) under different main loop timings:
+//   make motion
+// Holds MS_RGHT for HOLD_MS, then MS_RGHT and MS_DOWN together, with loops
+// every 100 us, every 1 ms, with 100 us loops broken by LED frames and a
+// flash write, and with random loop times up to 5 ms. Prints where the
+// cursor is after 100 ms, 300 ms and the whole hold, next to QMK's
+// mousekey_task() run on the same loop times (a copy of its timing and
+// acceleration with the default settings). The encoder scrolls a detent
+// every WHEEL_EVERY_MS meanwhile. Checks that the cursor ends up within a
+// pixel of the exact distance for every timing, that every detent reaches
+// the host and that no USB frame carries more than one mouse report.
+
+#include <math.h>
+#include <stdio.h>
+#include "sim.h"
+#include "mouse_motion.h"
+#include "mouse_batch.h"
+
+#define HOLD_MS 1000
+#define DIAGONAL_MS 500
+#define WHEEL_EVERY_MS 5
+
+typedef enum { LOOP_FAST, LOOP_SLOW, LOOP_RGB, LOOP_RANDOM } loop_t;
+
+static const char *const loop_names[] = {"100us", "1ms", "rgb_load", "random"};
+
+static host_driver_t *sim_driver;
+static host_driver_t  capture;
+static int32_t        cursor_x, cursor_y, wheel;
+static uint32_t       reports;
+static uint32_t       crowded_frames;
+static uint64_t       last_frame = UINT64_MAX;
+static uint32_t       rng        = 5;
+
+static uint32_t next_random(void) {
+    rng = rng * 1664525u + 1013904223u;
+    return rng >> 8;
+}
+
+static void capture_mouse(report_mouse_t *report) {
+    uint64_t frame = sim_now_us() / SIM_USB_POLL_US;
+
+    sim_driver->send_mouse(report);
+    crowded_frames += frame == last_frame;
+    last_frame = frame;
+    cursor_x += report->x;
+    cursor_y += report->y;
+    wheel += report->v;
+    reports++;
+}
+
+// QMK mousekey.c with MOUSEKEY_DELAY 10, INTERVAL 20, MOVE_DELTA 8,
+// MAX_SPEED 10, TIME_TO_MAX 30: one step when the interval has passed since
+// the last report, the step growing with the number of reports.
+typedef struct {
+    bool     held;
+    uint8_t  repeat;
+    uint16_t last;
+    int32_t  x;
+} stock_t;
+
+static void stock_press(stock_t *stock) {
+    stock->held   = true;
+    stock->repeat = 0;
+    stock->x += 8;
+    stock->last = timer_read();
+}
+
+static void stock_task(stock_t *stock) {
+    if (!stock->held || timer_elapsed(stock->last) < (stock->repeat ? 20 : 10)) {
+        return;
+    }
+    if (stock->repeat != UINT8_MAX) {
+        stock->repeat++;
+    }
+    int32_t unit = stock->repeat >= 30 ? 8 * 10 : MAX(1, 8 * 10 * stock->repeat / 30);
+    stock->x += unit;
+    stock->last = timer_read();
+}
+
+// Exact pixels after holding for us.
+static double exact(double us) {
+    double ramp = MOUSE_MOTION_ACCEL_MS * 1000.0, start = MOUSE_MOTION_SPEED_START, max = MOUSE_MOTION_SPEED_MAX;
+
+    if (us < ramp) {
+        return (start * us + (max - start) * us * us / (2 * ramp)) / 1e6;
+    }
+    return ((start + max) * ramp / 2 + max * (us - ramp)) / 1e6;
+}
+
+static uint32_t loop_us(loop_t loop, uint64_t at) {
+    switch (loop) {
+        case LOOP_FAST:
+            return 100;
+        case LOOP_SLOW:
+            return 1000;
+        case LOOP_RGB:
+            // An LED frame every 16 ms and a 20 ms flash write at 400 ms.
+            if (at / 100 % 160 == 0) {
+                return 3000;
+            }
+            return at >= 400000 && at < 400100 ? 20000 : 100;
+        default:
+            return 50 + next_random() % 4950;
+    }
+}
+
+int main(void) {
+    uint32_t bad = 0;
+    double   off = 0;
+
+    printf("%-9s %-7s %7s %7s %8s %8s %8s %8s %8s %8s %8s\n", "loops", "engine", "x@100", "x@300", "x_end", "y_end", "wheel", "reports", "crowded", "exact_x", "exact_y");
+    for (loop_t loop = LOOP_FAST; loop <= LOOP_RANDOM; loop++) {
+        sim_init();
+        sim_driver         = host_get_driver();
+        capture            = *sim_driver;
+        capture.send_mouse = capture_mouse;
+        host_set_driver(&capture);
+        // MS_DOWN and MS_RGHT are (1, 1) and (1, 3) on layer 2.
+        layer_move(2);
+        sim_scan();
+
+        cursor_x = cursor_y = wheel = 0;
+        reports = crowded_frames = 0;
+        last_frame               = UINT64_MAX;
+
+        stock_t  stock    = {0};
+        int32_t  at_100[] = {0, 0}, at_300[] = {0, 0};
+        uint64_t start    = sim_now_us();
+        int32_t  detents  = 0;
+
+        sim_key(1, 3, true);
+        stock_press(&stock);
+        bool     diagonal = false;
+        uint64_t turn_us  = 0;
+        while (sim_now_us() - start < (HOLD_MS + DIAGONAL_MS) * 1000ull) {
+            uint64_t held = sim_now_us() - start;
+            if (!diagonal && held >= HOLD_MS * 1000ull) {
+                sim_key(1, 1, true);
+                diagonal = true;
+                turn_us  = held;
+            }
+            if (held / 1000 / WHEEL_EVERY_MS >= detents) {
+                mouse_batch_wheel(1);
+                detents++;
+            }
+            sim_scan();
+            if (!diagonal) {
+                stock_task(&stock);
+            }
+            if (held < 100000) {
+                at_100[0] = cursor_x;
+                at_100[1] = stock.x;
+            }
+            if (held < 300000) {
+                at_300[0] = cursor_x;
+                at_300[1] = stock.x;
+            }
+            // The stock run stops at the end of the straight part.
+            if (!diagonal) {
+                stock.held = held < HOLD_MS * 1000ull;
+            }
+            sim_advance_us(loop_us(loop, held));
+        }
+        uint64_t end_us = sim_now_us() - start;
+        sim_key(1, 3, false);
+        sim_key(1, 1, false);
+        for (int frame = 0; frame < MOUSE_BATCH_INTERVAL_MS; frame++) {
+            sim_advance_us(SIM_USB_POLL_US);
+            sim_scan();
+        }
+        bad += mouse_motion_active();
+
+        // Straight until the turn, then both axes at 1/sqrt(2) of the speed,
+        // up to the release.
+        double slant   = (exact(end_us) - exact(turn_us)) / sqrt(2);
+        double exact_x = exact(turn_us) + slant, exact_y = slant;
+        bool   close = fabs(cursor_x - exact_x) <= 1.5 && fabs(cursor_y - exact_y) <= 1.5;
+        bad += !close || crowded_frames || wheel != detents;
+        off = MAX(off, MAX(fabs(cursor_x - exact_x), fabs(cursor_y - exact_y)));
+
+        printf("%-9s %-7s %7d %7d %8d %8d %5d/%-3d %8u %8u %8.1f %8.1f\n", loop_names[loop], "motion", at_100[0], at_300[0], cursor_x, cursor_y, wheel, detents, reports, crowded_frames, exact_x, exact_y);
+        printf("%-9s %-7s %7d %7d %8d %8s %8s %8s %8s %8.1f\n", "", "stock", at_100[1], at_300[1], stock.x, "", "", "", "", exact(HOLD_MS * 1000.0));
+    }
+    printf("motion: at most %.1f px from the exact path\n", off);
+
+    if (bad) {
+        fprintf(stderr, "%u checks failed\n", bad);
+    }
+    return bad ? 1 : 0;
+}
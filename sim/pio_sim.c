@@ -0,0 +1,174 @@
+#include <string.h>
+#include "pio_sim.h"
+
+void pio_sim_init(pio_sim_sm_t *sm, const uint16_t *program, uint8_t start, uint8_t wrap_target, uint8_t wrap) {
+    memset(sm, 0, sizeof(*sm));
+    sm->program         = program;
+    sm->pc              = start;
+    sm->wrap_target     = wrap_target;
+    sm->wrap            = wrap;
+    sm->out_shift_right = true;
+}
+
+bool pio_sim_rx_get(pio_sim_sm_t *sm, uint32_t *value) {
+    if (sm->rx_level == 0) {
+        return false;
+    }
+    *value = sm->rx_fifo[0];
+    memmove(sm->rx_fifo, sm->rx_fifo + 1, (PIO_SIM_FIFO_DEPTH - 1) * sizeof(uint32_t));
+    sm->rx_level--;
+    return true;
+}
+
+static uint32_t mask_of(uint8_t bits) {
+    return bits >= 32 ? 0xFFFFFFFFu : ((1u << bits) - 1);
+}
+
+static uint32_t read_source(pio_sim_sm_t *sm, uint8_t source) {
+    switch (source) {
+        case 0: return sm->pins >> sm->in_base;
+        case 1: return sm->x;
+        case 2: return sm->y;
+        case 6: return sm->isr;
+        case 7: return sm->osr;
+        default: return 0;
+    }
+}
+
+static uint32_t shift_out(pio_sim_sm_t *sm, uint8_t bits) {
+    uint32_t data;
+
+    if (sm->out_shift_right) {
+        data    = sm->osr & mask_of(bits);
+        sm->osr = bits >= 32 ? 0 : sm->osr >> bits;
+    } else {
+        data    = bits >= 32 ? sm->osr : sm->osr >> (32 - bits);
+        sm->osr = bits >= 32 ? 0 : sm->osr << bits;
+    }
+    sm->osr_count += bits;
+    return data;
+}
+
+static void shift_in(pio_sim_sm_t *sm, uint32_t data, uint8_t bits) {
+    data &= mask_of(bits);
+    if (sm->in_shift_right) {
+        sm->isr = (bits >= 32 ? 0 : sm->isr >> bits) | (data << (32 - bits));
+    } else {
+        sm->isr = (bits >= 32 ? 0 : sm->isr << bits) | data;
+    }
+    sm->isr_count += bits;
+}
+
+static bool jmp_taken(pio_sim_sm_t *sm, uint8_t condition) {
+    bool taken;
+
+    switch (condition) {
+        case 0: return true;
+        case 1: return sm->x == 0;
+        case 2:
+            taken = sm->x != 0;
+            sm->x--;
+            return taken;
+        case 3: return sm->y == 0;
+        case 4:
+            taken = sm->y != 0;
+            sm->y--;
+            return taken;
+        case 5: return sm->x != sm->y;
+        case 7: return sm->osr_count < 32;
+        default: return false;
+    }
+}
+
+void pio_sim_step(pio_sim_sm_t *sm) {
+    if (sm->delay) {
+        sm->delay--;
+        return;
+    }
+
+    uint16_t instr    = sm->program[sm->pc];
+    uint8_t  opcode   = instr >> 13;
+    uint8_t  delay    = (instr >> 8) & 0x1F;
+    uint8_t  field    = (instr >> 5) & 0x7;
+    uint8_t  operand  = instr & 0x1F;
+    uint8_t  bits     = operand ? operand : 32;
+    bool     advanced = false;
+
+    switch (opcode) {
+        case 0: // jmp
+            if (jmp_taken(sm, field)) {
+                sm->pc   = operand;
+                advanced = true;
+            }
+            break;
+        case 2: // in
+            shift_in(sm, read_source(sm, field), bits);
+            break;
+        case 3: { // out
+            uint32_t data = shift_out(sm, bits);
+            switch (field) {
+                case 1: sm->x = data; break;
+                case 2: sm->y = data; break;
+                case 5:
+                    sm->pc   = data;
+                    advanced = true;
+                    break;
+                case 6:
+                    sm->isr       = data;
+                    sm->isr_count = bits;
+                    break;
+                default: break;
+            }
+            break;
+        }
+        case 4: // push / pull
+            if (!(field & 4)) {
+                if (sm->rx_level < PIO_SIM_FIFO_DEPTH) {
+                    sm->rx_fifo[sm->rx_level++] = sm->isr;
+                } else {
+                    sm->rx_dropped++;
+                }
+                sm->isr       = 0;
+                sm->isr_count = 0;
+            }
+            break;
+        case 5: { // mov
+            uint32_t data = read_source(sm, operand & 7);
+            uint8_t  op   = (operand >> 3) & 3;
+            if (op == 1) {
+                data = ~data;
+            }
+            switch (field) {
+                case 1: sm->x = data; break;
+                case 2: sm->y = data; break;
+                case 5:
+                    sm->pc   = data & 0x1F;
+                    advanced = true;
+                    break;
+                case 6:
+                    sm->isr       = data;
+                    sm->isr_count = 0;
+                    break;
+                case 7:
+                    sm->osr       = data;
+                    sm->osr_count = 0;
+                    break;
+                default: break;
+            }
+            break;
+        }
+        case 7: // set
+            if (field == 1) {
+                sm->x = operand;
+            } else if (field == 2) {
+                sm->y = operand;
+            }
+            break;
+        default: break;
+    }
+
+    if (!advanced) {
+        sm->pc = sm->pc == sm->wrap ? sm->wrap_target : sm->pc + 1;
+    }
+    sm->delay = delay;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// Cycle-level model of one RP2040 PIO state machine, covering the
+// instructions used by the programs in this keyboard (jmp, in, out, push,
+// mov, set, delays and wrap). Enough to run a hand-assembled program against
+// synthetic pin waveforms.
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define PIO_SIM_FIFO_DEPTH 4
+
+typedef struct {
+    const uint16_t *program;
+    uint8_t         wrap_target;
+    uint8_t         wrap;
+    uint8_t         in_base;
+    bool            in_shift_right;
+    bool            out_shift_right;
+
+    uint8_t  pc;
+    uint8_t  delay;
+    uint32_t x;
+    uint32_t y;
+    uint32_t isr;
+    uint32_t osr;
+    uint8_t  isr_count;
+    uint8_t  osr_count;
+    uint32_t pins;
+
+    uint32_t rx_fifo[PIO_SIM_FIFO_DEPTH];
+    uint8_t  rx_level;
+    uint32_t rx_dropped;
+} pio_sim_sm_t;
+
+void pio_sim_init(pio_sim_sm_t *sm, const uint16_t *program, uint8_t start, uint8_t wrap_target, uint8_t wrap);
+void pio_sim_step(pio_sim_sm_t *sm);
+bool pio_sim_rx_get(pio_sim_sm_t *sm, uint32_t *value);
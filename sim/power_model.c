@@ -0,0 +1,170 @@
+// Runs the default keymap with POWER_SAVE_ENABLE through typing, an idle
+// pause, a pause past POWER_SLEEP_MS and a USB suspend that a key press
+// wakes, then reads the per-state counters through the raw HID command the
+// way a host would:
+//   ./build/power_model | ../tools/trace_decode.py --power --input -
+// An awake loop is modelled as LOOP_US; on the device --loop-stats shows the
+// real figure. The suspend part follows QMK's ChibiOS suspend loop: a
+// wait_ms(17) per pass, a matrix scan as wake-up condition, then remote
+// wakeup and a driver restart that the host takes RESUME_MS to configure.
+// Checks that the key which woke the host reaches it, that the layer effect
+// engine blanks the strip once per suspend rather than on every pass, and
+// that once a host has sent a raw HID packet the next ones are not held
+// back by sleeps.
+
+#include <stdio.h>
+#include "sim.h"
+#include "host_cmd.h"
+#include "raw_hid.h"
+#include "usb_main.h"
+#include "power.h"
+#include "rgb_effect.h"
+#include "rgb_state.h"
+
+#define LOOP_US 20
+#define QMK_SUSPEND_WAIT_MS 17
+#define RESUME_MS 100
+#define PACKET 32
+#define HOST_PACKETS 20
+// Not a multiple of the sleep period, so packets land all over it.
+#define HOST_EVERY_US 47300
+
+static host_driver_t *sim_driver;
+static host_driver_t  capture;
+static bool           host_saw_key;
+static bool           quiet;
+
+void raw_hid_send(uint8_t *data, uint8_t length) {
+    if (quiet) {
+        return;
+    }
+    for (uint8_t i = 0; i < length; i++) {
+        printf("%02x", data[i]);
+    }
+    printf("\n");
+}
+
+static void capture_keyboard(report_keyboard_t *report) {
+    if (sim_usb_driver.state == USB_ACTIVE && report->keys[0] == KC_P1) {
+        host_saw_key = true;
+    }
+    sim_driver->send_keyboard(report);
+}
+
+static void loop_until(uint64_t us) {
+    while (sim_now_us() < us) {
+        sim_advance_us(LOOP_US);
+        sim_scan();
+    }
+}
+
+// The edge wakes a sleeping loop; the next loop's scan sees the key.
+static void key_at(uint64_t us, bool pressed) {
+    sim_wake_at(us);
+    loop_until(us);
+    sim_wake_at(UINT64_MAX);
+    sim_advance_us(LOOP_US);
+    sim_key(4, 0, pressed);
+}
+
+static uint64_t ms(uint64_t n) {
+    return n * 1000;
+}
+
+// Packets every HOST_EVERY_US after an idle pause, each handled by the
+// first loop after it arrives. Returns the longest wait of all but the
+// first, which may find the loop asleep.
+static uint64_t host_session(void) {
+    uint64_t worst = 0;
+
+    quiet = true;
+    for (uint8_t i = 0; i < HOST_PACKETS; i++) {
+        uint64_t arrives        = sim_now_us() + HOST_EVERY_US;
+        uint8_t  packet[PACKET] = {0};
+        loop_until(arrives);
+        raw_hid_receive(packet, sizeof(packet));
+        if (i) {
+            worst = MAX(worst, sim_now_us() - arrives);
+        }
+    }
+    quiet = false;
+    return worst;
+}
+
+// Returns the LED frames sent while suspended.
+static uint32_t suspend_until_key(uint64_t press_at) {
+    uint32_t frames = sim_stats.led_frames;
+
+    sim_usb_driver.state = USB_SUSPENDED;
+    sim_wake_at(press_at);
+    do {
+        suspend_power_down_kb();
+        sim_advance_us(ms(QMK_SUSPEND_WAIT_MS));
+    } while (sim_now_us() < press_at);
+    frames = sim_stats.led_frames - frames;
+
+    // usbWakeupHost() and restart_usb_driver(): enumerating again.
+    sim_usb_driver.state = USB_READY;
+    suspend_wakeup_init_kb();
+    uint64_t configured_at = sim_now_us() + ms(RESUME_MS);
+
+    sim_advance_us(LOOP_US);
+    sim_key(4, 0, true);
+    loop_until(sim_now_us() + ms(60));
+    sim_key(4, 0, false);
+    loop_until(configured_at);
+    sim_usb_driver.state = USB_ACTIVE;
+    loop_until(sim_now_us() + ms(50));
+    return frames;
+}
+
+int main(void) {
+    sim_init();
+    sim_driver            = host_get_driver();
+    capture               = *sim_driver;
+    capture.send_keyboard = capture_keyboard;
+    host_set_driver(&capture);
+
+    for (uint8_t i = 0; i < 20; i++) {
+        key_at(sim_now_us() + ms(90), true);
+        key_at(sim_now_us() + ms(60), false);
+    }
+
+    key_at(sim_now_us() + ms(30000), true);
+    key_at(sim_now_us() + ms(80), false);
+
+    key_at(sim_now_us() + ms(POWER_SLEEP_MS + 60000), true);
+    key_at(sim_now_us() + ms(80), false);
+
+    loop_until(sim_now_us() + ms(5000));
+    uint64_t host_wait_us = host_session();
+
+    // Pressed 25 ms into one of power.c's sleeps. A press during QMK's own
+    // wait_ms(17) is found by its wake-up scan instead, without an edge
+    // timestamp, and is held and replayed the same way.
+    // The effect engine draws its own frames and has to blank the strip
+    // itself.
+    rgb_state_request(true, RGB_EFFECT_MODE_LAYER, 0, 255, 80);
+    loop_until(sim_now_us() + ms(2000));
+    host_saw_key           = false;
+    uint32_t asleep_frames = suspend_until_key(sim_now_us() + ms(400 * (POWER_SUSPEND_SLEEP_MS + QMK_SUSPEND_WAIT_MS) + 25));
+
+    for (uint8_t state = 0; state < POWER_STATES; state++) {
+        uint8_t packet[PACKET] = {HOST_CMD_ID, HOST_CMD_POWER_STATS, state};
+        raw_hid_receive(packet, sizeof(packet));
+    }
+
+    if (!host_saw_key || sim_stats.dropped_reports) {
+        fprintf(stderr, "key after suspend %s, %u reports dropped\n", host_saw_key ? "sent" : "LOST", sim_stats.dropped_reports);
+        return 1;
+    }
+    if (asleep_frames > 1) {
+        fprintf(stderr, "%u LED frames sent while suspended\n", asleep_frames);
+        return 1;
+    }
+    if (host_wait_us > ms(1)) {
+        fprintf(stderr, "raw hid packets waited up to %lu us for a sleeping loop\n", (unsigned long)host_wait_us);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,211 @@
+// Keymap profiles (profile.c) from an image packed by tools/profiles.py:
+//   make profiles
+// Loads the image into the simulated flash at PROFILE_FLASH_OFFSET and
+// boots. The numpad profile is the compiled keymap written out as JSON, so
+// every layer of it must read back as the keymap does; that also checks the
+// packer's keycode names. The editing profile's base layer is the keymap's
+// layer 1. Then switches with PF_NEXT and the raw HID command, checks that
+// keys resolve through the new profile and that nothing is written to flash,
+// and that an image with a bad CRC leaves only the keymap. Switch times are
+// host ns, only good for comparing with a key lookup.
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "sim.h"
+#include "host_cmd.h"
+#include "keymap_introspection.h"
+#include "profile.h"
+#include "raw_hid.h"
+#include "hardware/regs/addressmap.h"
+
+#define PACKET 32
+#define SWITCH_REPEAT 20000
+
+static uint8_t reply[PACKET];
+static bool    replied;
+
+void raw_hid_send(uint8_t *data, uint8_t length) {
+    memcpy(reply, data, MIN(length, PACKET));
+    replied = true;
+}
+
+static uint64_t wall_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static uint16_t keycode_at(uint8_t layer, uint8_t row, uint8_t col) {
+    return keymap_key_to_keycode(layer, (keypos_t){.row = row, .col = col});
+}
+
+// What a press does under the current layers, as QMK's layer walk finds it.
+static uint16_t effective_at(uint8_t row, uint8_t col) {
+    layer_state_t active = layer_state | default_layer_state;
+
+    for (int8_t layer = MAX_LAYER - 1; layer >= 0; layer--) {
+        uint16_t keycode = keycode_at(layer, row, col);
+        if ((active & ((layer_state_t)1 << layer)) && keycode != KC_TRNS) {
+            return keycode;
+        }
+    }
+    return keycode_at(0, row, col);
+}
+
+static bool profile_command(uint8_t select, uint8_t named) {
+    uint8_t data[PACKET] = {HOST_CMD_ID, HOST_CMD_PROFILE, select, named};
+
+    replied = false;
+    raw_hid_receive(data, PACKET);
+    return replied && reply[1] == HOST_CMD_PROFILE;
+}
+
+static void tap(uint8_t row, uint8_t col) {
+    sim_key(row, col, true);
+    sim_scan();
+    sim_advance_us(10000);
+    sim_key(row, col, false);
+    sim_scan();
+    sim_advance_us(10000);
+}
+
+// MO(4) at (0,2) held, PF_NEXT at (3,2) on layer 4.
+static void press_next(void) {
+    sim_key(0, 2, true);
+    sim_scan();
+    sim_advance_us(10000);
+    tap(3, 2);
+    sim_key(0, 2, false);
+    sim_scan();
+    sim_advance_us(10000);
+}
+
+// Keys of one profile layer that differ from a keymap layer, except the
+// positions in skip.
+static uint32_t compare_layer(uint8_t profile_layer, uint8_t keymap_layer, const keypos_t *skip, uint8_t skips) {
+    uint32_t differ = 0;
+
+    for (uint8_t row = 0; row < MATRIX_ROWS; row++) {
+        for (uint8_t col = 0; col < MATRIX_COLS; col++) {
+            bool skipped = false;
+            for (uint8_t i = 0; i < skips; i++) {
+                skipped |= skip[i].row == row && skip[i].col == col;
+            }
+            uint16_t keymap = keycode_at_keymap_location_raw(keymap_layer, row, col);
+            if (!skipped && keycode_at(profile_layer, row, col) != keymap) {
+                printf("  layer %u (%u,%u): 0x%04x, keymap 0x%04x\n", profile_layer, row, col, keycode_at(profile_layer, row, col), keymap);
+                differ++;
+            }
+        }
+    }
+    return differ;
+}
+
+static bool load(const char *path) {
+    FILE *f = fopen(path, "rb");
+
+    if (!f) {
+        perror(path);
+        return false;
+    }
+    memset(&sim_flash[PROFILE_FLASH_OFFSET], 0xFF, SIM_FLASH_SIZE - PROFILE_FLASH_OFFSET);
+    size_t size = fread(&sim_flash[PROFILE_FLASH_OFFSET], 1, SIM_FLASH_SIZE - PROFILE_FLASH_OFFSET, f);
+    fclose(f);
+    return size > sizeof(profile_image_t);
+}
+
+int main(int argc, char **argv) {
+    uint32_t bad = 0;
+
+    if (argc != 2 || !load(argv[1])) {
+        fprintf(stderr, "usage: %s profiles.bin\n", argv[0]);
+        return 1;
+    }
+    sim_init();
+    sim_scan();
+    printf("%u profiles:", profile_count());
+    for (uint8_t i = 0; i < profile_count(); i++) {
+        printf(" %d:%.*s", i, PROFILE_NAME_LEN, profile_name(i));
+    }
+    printf("\n");
+    bad += profile_count() != 4 || profile_current() != 0;
+
+    uint32_t flash_writes = sim_stats.flash_writes;
+    uint16_t keymap_p7    = effective_at(2, 0);
+
+    // 1: numpad, the keymap itself.
+    press_next();
+    bad += profile_current() != 1;
+    uint32_t differ = 0;
+    for (uint8_t layer = 0; layer < keymap_layer_count(); layer++) {
+        differ += compare_layer(layer, layer, NULL, 0);
+    }
+    printf("numpad: %u keys differ from the keymap\n", differ);
+    bad += differ != 0;
+    bad += effective_at(2, 0) != keymap_p7;
+
+    // 2: editing, base layer from the keymap's layer 1 but for its MO(1) and
+    // the encoder button.
+    press_next();
+    bad += profile_current() != 2;
+    const keypos_t own[] = {{.row = 0, .col = 1}, {.row = 6, .col = 0}};
+    differ               = compare_layer(0, 1, own, ARRAY_SIZE(own));
+    printf("editing: %u base keys differ from keymap layer 1\n", differ);
+    bad += differ != 0;
+    bad += effective_at(2, 0) != keycode_at_keymap_location_raw(1, 2, 0);
+
+    // Momentary layers come from the profile too.
+    sim_key(0, 1, true);
+    sim_scan();
+    bad += effective_at(2, 0) != keymap_p7;
+    sim_key(0, 1, false);
+    sim_scan();
+    sim_advance_us(10000);
+
+    // 3: macropad, then around to the keymap.
+    press_next();
+    bad += profile_current() != 3 || effective_at(2, 0) != KC_F14;
+    press_next();
+    bad += profile_current() != 0 || effective_at(2, 0) != keymap_p7;
+
+    // Raw HID: select, name another, refuse one past the end.
+    bool ok = profile_command(2, 0xFF) && reply[2] == 2 && reply[3] == 4 && strncmp((const char *)&reply[4], "editing", PROFILE_NAME_LEN) == 0;
+    ok &= profile_command(0xFF, 3) && reply[2] == 2 && strncmp((const char *)&reply[4], "macropad", PROFILE_NAME_LEN) == 0;
+    ok &= profile_command(0xFF, 0) && strncmp((const char *)&reply[4], "keymap", PROFILE_NAME_LEN) == 0;
+    ok &= !profile_command(4, 0xFF) && replied && profile_current() == 2;
+    printf("raw hid: %s\n", ok ? "ok" : "FAILED");
+    bad += !ok || effective_at(2, 0) != keycode_at_keymap_location_raw(1, 2, 0);
+
+    printf("flash writes while switching: %u\n", sim_stats.flash_writes - flash_writes);
+    bad += sim_stats.flash_writes != flash_writes;
+
+    // Switch cost against a single lookup.
+    uint64_t start = wall_ns();
+    for (uint32_t i = 0; i < SWITCH_REPEAT; i++) {
+        profile_select(i % profile_count());
+    }
+    uint64_t switch_ns = (wall_ns() - start) / SWITCH_REPEAT;
+    volatile uint16_t sink = 0;
+    start = wall_ns();
+    for (uint32_t i = 0; i < SWITCH_REPEAT; i++) {
+        sink += keycode_at(i % 5, i % MATRIX_ROWS, i % MATRIX_COLS);
+    }
+    uint64_t lookup_ns = (wall_ns() - start) / SWITCH_REPEAT;
+    printf("switch %lu ns, lookup %lu ns (host)\n", (unsigned long)switch_ns, (unsigned long)lookup_ns);
+
+    // Every boot starts on the keymap.
+    sim_init();
+    bad += profile_current() != 0 || effective_at(2, 0) != keymap_p7;
+
+    // A corrupted image is ignored.
+    sim_flash[PROFILE_FLASH_OFFSET + sizeof(profile_image_t) + 40] ^= 0x01;
+    sim_init();
+    printf("bad crc: %u profiles\n", profile_count());
+    bad += profile_count() != 1 || profile_select(1);
+
+    if (bad) {
+        fprintf(stderr, "%u checks failed\n", bad);
+    }
+    return bad ? 1 : 0;
+}
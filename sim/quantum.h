@@ -0,0 +1,312 @@
+#pragma once
+
+// Host-side stand-in for the slice of QMK that this keyboard and its keymaps
+// use. Only what the sources reference is declared here; keycode values match
+// QMK so tables and ranges behave the same as on the device.
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include "timer.h"
+
+#define PROGMEM
+#define ARRAY_SIZE(array) (sizeof(array) / sizeof((array)[0]))
+#define MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+#define GP0 0
+#define GP1 1
+#define GP2 2
+#define GP3 3
+#define GP4 4
+#define GP5 5
+#define GP6 6
+#define GP7 7
+#define GP8 8
+#define GP9 9
+#define GP10 10
+#define GP11 11
+#define GP12 12
+#define GP13 13
+#define SIM_PIN_COUNT 30
+
+typedef uint8_t pin_t;
+
+#include "config.h"
+
+#define MATRIX_ROWS 7
+#define MATRIX_COLS 4
+#define RGBLIGHT_LED_COUNT 10
+
+typedef uint8_t matrix_row_t;
+
+#ifdef LAYER_STATE_8BIT
+#    define MAX_LAYER 8
+typedef uint8_t layer_state_t;
+#else
+#    define MAX_LAYER 32
+typedef uint32_t layer_state_t;
+#endif
+
+typedef struct {
+    uint8_t col;
+    uint8_t row;
+} keypos_t;
+
+typedef int8_t mouse_xy_report_t;
+typedef int8_t mouse_hv_report_t;
+
+typedef struct {
+    uint8_t           buttons;
+    mouse_xy_report_t x;
+    mouse_xy_report_t y;
+    mouse_hv_report_t v;
+    mouse_hv_report_t h;
+} report_mouse_t;
+
+typedef struct {
+    uint8_t mods;
+    uint8_t reserved;
+    uint8_t keys[6];
+} report_keyboard_t;
+
+typedef struct {
+    uint8_t report_id;
+    uint8_t mods;
+    uint8_t bits[30];
+} report_nkro_t;
+
+typedef struct {
+    uint8_t  report_id;
+    uint16_t usage;
+} report_extra_t;
+
+typedef struct {
+    uint8_t (*keyboard_leds)(void);
+    void (*send_keyboard)(report_keyboard_t *);
+    void (*send_nkro)(report_nkro_t *);
+    void (*send_mouse)(report_mouse_t *);
+    void (*send_extra)(report_extra_t *);
+} host_driver_t;
+
+typedef struct {
+    keypos_t key;
+    bool     pressed;
+    uint16_t time;
+} keyevent_t;
+
+typedef struct {
+    keyevent_t event;
+} keyrecord_t;
+
+enum qk_keycode_defines {
+    KC_NO   = 0x0000,
+    KC_TRNS = 0x0001,
+    KC_TRANSPARENT = KC_TRNS,
+    KC_A    = 0x0004,
+    KC_C    = 0x0006,
+    KC_R    = 0x0015,
+    KC_S    = 0x0016,
+    KC_V    = 0x0019,
+    KC_X    = 0x001B,
+    KC_Y    = 0x001C,
+    KC_Z    = 0x001D,
+    KC_0    = 0x0027,
+    KC_ENT  = 0x0028,
+    KC_ESC  = 0x0029,
+    KC_BSPC = 0x002A,
+    KC_TAB  = 0x002B,
+    KC_SPACE = 0x002C,
+    KC_COMM = 0x0036,
+    KC_SLASH = 0x0038,
+    KC_F14  = 0x0069,
+    KC_F15,
+    KC_F16,
+    KC_F17,
+    KC_F18,
+    KC_F19,
+    KC_F20,
+    KC_F21,
+    KC_F22,
+    KC_HOME = 0x004A,
+    KC_DEL  = 0x004C,
+    KC_END  = 0x004D,
+    KC_RGHT = 0x004F,
+    KC_LEFT = 0x0050,
+    KC_DOWN = 0x0051,
+    KC_UP   = 0x0052,
+    KC_NUM  = 0x0053,
+    KC_PSLS = 0x0054,
+    KC_PAST = 0x0055,
+    KC_PMNS = 0x0056,
+    KC_PPLS = 0x0057,
+    KC_PENT = 0x0058,
+    KC_P1   = 0x0059,
+    KC_P2,
+    KC_P3,
+    KC_P4,
+    KC_P5,
+    KC_P6,
+    KC_P7,
+    KC_P8,
+    KC_P9,
+    KC_P0,
+    KC_PDOT = 0x0063,
+    KC_PEQL = 0x0067,
+    MS_UP   = 0x00CD,
+    MS_DOWN = 0x00CE,
+    MS_LEFT = 0x00CF,
+    MS_RGHT = 0x00D0,
+    MS_BTN1 = 0x00D1,
+    MS_BTN2 = 0x00D2,
+    MS_WHLU = 0x00D9,
+    MS_WHLD = 0x00DA,
+    KC_LCTL = 0x00E0,
+    KC_LSFT = 0x00E1,
+    KC_LALT = 0x00E2,
+    KC_LGUI = 0x00E3,
+    QK_MODS          = 0x0100,
+    QK_LCTL          = 0x0100,
+    QK_LSFT          = 0x0200,
+    QK_LALT          = 0x0400,
+    QK_LGUI          = 0x0800,
+    QK_MODS_MAX      = 0x1FFF,
+    QK_TO            = 0x5200,
+    QK_MOMENTARY     = 0x5220,
+    QK_MOMENTARY_MAX = 0x523F,
+    QK_KB_0          = 0x7E00,
+    QK_USER_0        = 0x7E40,
+    SAFE_RANGE       = QK_USER_0,
+};
+
+#define QK_MODS_GET_MODS(kc) (((kc) >> 8) & 0x1F)
+#define QK_MODS_GET_BASIC_KEYCODE(kc) ((kc) & 0xFF)
+
+#define LCTL(kc) (QK_LCTL | (kc))
+#define LSFT(kc) (QK_LSFT | (kc))
+#define LALT(kc) (QK_LALT | (kc))
+#define LGUI(kc) (QK_LGUI | (kc))
+#define S(kc) LSFT(kc)
+#define MO(layer) (QK_MOMENTARY | ((layer)&0x1F))
+#define TO(layer) (QK_TO | ((layer)&0x1F))
+
+#define LAYOUT_6x4( \
+    k00, k01, k02, k03, \
+    k10, k11, k12, k13, \
+    k20, k21, k22, k23, \
+    k30, k31, k32, k33, \
+    k40, k41, k42, k43, \
+    k50, k51, k52, k53, \
+    k60                 \
+) { \
+    { k00, k01, k02, k03 }, \
+    { k10, k11, k12, k13 }, \
+    { k20, k21, k22, k23 }, \
+    { k30, k31, k32, k33 }, \
+    { k40, k41, k42, k43 }, \
+    { k50, k51, k52, k53 }, \
+    { k60, KC_NO, KC_NO, KC_NO } \
+}
+
+#define RGBLIGHT_MODE_STATIC_LIGHT 1
+#define RGBLIGHT_MODE_BREATHING 2
+
+extern bool debug_enable;
+extern bool debug_matrix;
+extern bool debug_keyboard;
+
+extern layer_state_t layer_state;
+extern layer_state_t default_layer_state;
+
+uint8_t get_highest_layer(layer_state_t state);
+void    layer_state_set(layer_state_t state);
+void    layer_on(uint8_t layer);
+void    layer_off(uint8_t layer);
+void    layer_move(uint8_t layer);
+void    layer_clear(void);
+void    default_layer_set(layer_state_t state);
+
+void register_code(uint8_t code);
+void unregister_code(uint8_t code);
+void register_mods(uint8_t mods);
+void unregister_mods(uint8_t mods);
+void register_code16(uint16_t keycode);
+void unregister_code16(uint16_t keycode);
+void tap_code16(uint16_t keycode);
+void clear_keyboard(void);
+
+report_mouse_t mousekey_get_report(void);
+void           host_mouse_send(report_mouse_t *report);
+host_driver_t *host_get_driver(void);
+void           host_set_driver(host_driver_t *driver);
+
+// Trace timestamps come from the simulator clock.
+uint64_t sim_now_us(void);
+#define TRACE_NOW() ((uint32_t)sim_now_us())
+
+uint32_t eeconfig_read_user(void);
+void     eeconfig_update_user(uint32_t value);
+void     eeconfig_init(void);
+void     eeconfig_init_kb(void);
+void     eeconfig_init_user(void);
+
+uint32_t last_input_activity_elapsed(void);
+
+// ChibiOS, as far as power.c uses it. A semaphore wait advances the
+// simulator clock to the timeout or the next scheduled wake edge.
+typedef int32_t  msg_t;
+typedef uint32_t sysinterval_t;
+typedef struct {
+    bool taken;
+} binary_semaphore_t;
+
+#define MSG_OK 0
+#define MSG_TIMEOUT -1
+#define TIME_MS2I(ms) ((sysinterval_t)(ms))
+#define chSysLockFromISR() ((void)0)
+#define chSysUnlockFromISR() ((void)0)
+
+void  chBSemObjectInit(binary_semaphore_t *bsp, bool taken);
+void  chBSemReset(binary_semaphore_t *bsp, bool taken);
+void  chBSemSignalI(binary_semaphore_t *bsp);
+msg_t chBSemWaitTimeout(binary_semaphore_t *bsp, sysinterval_t timeout);
+
+#define dprintf(...) ((void)0)
+
+void setPinInputHigh(pin_t pin);
+bool readPin(pin_t pin);
+
+void rgblight_enable_noeeprom(void);
+void rgblight_disable_noeeprom(void);
+void rgblight_mode_noeeprom(uint8_t mode);
+void rgblight_sethsv_noeeprom(uint8_t hue, uint8_t sat, uint8_t val);
+
+extern const uint16_t keymaps[][MATRIX_ROWS][MATRIX_COLS];
+
+uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key);
+
+void          keyboard_pre_init_kb(void);
+void          keyboard_pre_init_user(void);
+void          keyboard_post_init_kb(void);
+void          keyboard_post_init_user(void);
+void          matrix_scan_kb(void);
+void          matrix_scan_user(void);
+void          housekeeping_task_kb(void);
+void          housekeeping_task_user(void);
+void          suspend_power_down_kb(void);
+void          suspend_power_down_user(void);
+void          suspend_wakeup_init_kb(void);
+void          suspend_wakeup_init_user(void);
+bool          pre_process_record_kb(uint16_t keycode, keyrecord_t *record);
+bool          pre_process_record_user(uint16_t keycode, keyrecord_t *record);
+void          process_record(keyrecord_t *record);
+void          action_tapping_process(keyrecord_t record);
+bool          process_record_kb(uint16_t keycode, keyrecord_t *record);
+bool          process_record_user(uint16_t keycode, keyrecord_t *record);
+layer_state_t layer_state_set_kb(layer_state_t state);
+layer_state_t layer_state_set_user(layer_state_t state);
+layer_state_t default_layer_state_set_kb(layer_state_t state);
+layer_state_t default_layer_state_set_user(layer_state_t state);
+bool          encoder_update_kb(uint8_t index, bool clockwise);
+bool          encoder_update_user(uint8_t index, bool clockwise);
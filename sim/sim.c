@@ -0,0 +1,656 @@
+#include <string.h>
+#include "sim.h"
+#include "trace.h"
+#include "raw_hid.h"
+#include "keymap_introspection.h"
+#include "ws2812.h"
+#include "usb_main.h"
+#include "power.h"
+#include "hardware/structs/usb.h"
+#include "hardware/regs/addressmap.h"
+#ifdef DYNAMIC_KEYMAP_ENABLE
+#    include "dynamic_keymap.h"
+#    include "via.h"
+#endif
+
+sim_stats_t sim_stats;
+USBDriver   sim_usb_driver;
+// Erased flash; kept across sim_init() like the real thing.
+uint8_t sim_flash[SIM_FLASH_SIZE];
+
+bool debug_enable;
+bool debug_matrix;
+bool debug_keyboard;
+
+layer_state_t layer_state;
+layer_state_t default_layer_state = 1;
+
+static uint64_t now_us;
+static bool     pins[SIM_PIN_COUNT];
+static uint8_t  source_layer[MATRIX_ROWS][MATRIX_COLS];
+
+static uint32_t eeconfig_user;
+static uint32_t input_at;
+static uint8_t  report_mods;
+static uint8_t report_keys[32];
+
+uint16_t timer_read(void) {
+    return (uint16_t)(now_us / 1000);
+}
+
+uint32_t timer_read32(void) {
+    return (uint32_t)(now_us / 1000);
+}
+
+uint16_t timer_elapsed(uint16_t last) {
+    return (uint16_t)(timer_read() - last);
+}
+
+uint32_t timer_elapsed32(uint32_t last) {
+    return timer_read32() - last;
+}
+
+fast_timer_t timer_read_fast(void) {
+    return timer_read32();
+}
+
+fast_timer_t timer_elapsed_fast(fast_timer_t last) {
+    return timer_read_fast() - last;
+}
+
+uint64_t sim_now_us(void) {
+    return now_us;
+}
+
+void sim_advance_us(uint32_t us) {
+    now_us += us;
+}
+
+void sim_set_pin(pin_t pin, bool level) {
+    pins[pin] = level;
+}
+
+void setPinInputHigh(pin_t pin) {
+    pins[pin] = true;
+}
+
+bool readPin(pin_t pin) {
+    return pins[pin];
+}
+
+// rgblight: every call that reaches rgblight_set() on the device encodes and
+// pushes the whole strip. Mode and colour calls are latched silently while
+// the strip is disabled, as in rgblight.c.
+
+static bool rgb_enabled = true;
+
+void rgblight_enable_noeeprom(void) {
+    rgb_enabled = true;
+    sim_stats.rgb_calls++;
+    sim_stats.led_frames++;
+}
+
+void rgblight_disable_noeeprom(void) {
+    rgb_enabled = false;
+    sim_stats.rgb_calls++;
+    sim_stats.led_frames++;
+}
+
+void rgblight_mode_noeeprom(uint8_t mode) {
+    (void)mode;
+    sim_stats.rgb_calls++;
+    if (rgb_enabled) {
+        sim_stats.led_frames++;
+    }
+}
+
+void rgblight_sethsv_noeeprom(uint8_t hue, uint8_t sat, uint8_t val) {
+    (void)hue;
+    (void)sat;
+    (void)val;
+    sim_stats.rgb_calls++;
+    if (rgb_enabled) {
+        sim_stats.led_frames++;
+    }
+}
+
+// WS2812 driver, as the effect engine uses it. Every flush pushes a frame.
+
+static uint8_t strip[RGBLIGHT_LED_COUNT][3];
+
+void ws2812_init(void) {}
+
+void ws2812_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
+    if (index >= 0 && index < RGBLIGHT_LED_COUNT) {
+        strip[index][0] = red;
+        strip[index][1] = green;
+        strip[index][2] = blue;
+    }
+}
+
+void ws2812_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
+    for (int i = 0; i < RGBLIGHT_LED_COUNT; i++) {
+        ws2812_set_color(i, red, green, blue);
+    }
+}
+
+void ws2812_flush(void) {
+    sim_stats.led_frames++;
+}
+
+const uint8_t *sim_strip_led(uint8_t index) {
+    return strip[index];
+}
+
+uint8_t sim_strip_lit(void) {
+    uint8_t lit = 0;
+
+    for (uint8_t i = 0; i < RGBLIGHT_LED_COUNT; i++) {
+        lit += (strip[i][0] | strip[i][1] | strip[i][2]) != 0;
+    }
+    return lit;
+}
+
+uint8_t get_highest_layer(layer_state_t state) {
+    return state ? (uint8_t)(31 - __builtin_clz(state)) : 0;
+}
+
+void layer_state_set(layer_state_t state) {
+    layer_state = layer_state_set_kb(state);
+}
+
+void layer_on(uint8_t layer) {
+    layer_state_set(layer_state | ((layer_state_t)1 << layer));
+}
+
+void layer_off(uint8_t layer) {
+    layer_state_set(layer_state & ~((layer_state_t)1 << layer));
+}
+
+void layer_clear(void) {
+    layer_state_set(0);
+}
+
+void layer_move(uint8_t layer) {
+    layer_state_set((layer_state_t)1 << layer);
+}
+
+void default_layer_set(layer_state_t state) {
+    default_layer_state = default_layer_state_set_kb(state);
+}
+
+static bool is_mouse_keycode(uint16_t keycode) {
+    return keycode >= MS_UP && keycode <= MS_WHLD;
+}
+
+// The USB side: every report that reaches the host driver is counted, and
+// a second keyboard report within one poll interval waits for the next poll.
+static uint64_t key_report_poll = UINT64_MAX;
+
+static void wait_for_poll(void) {
+    uint64_t poll = now_us / SIM_USB_POLL_US;
+
+    if (poll == key_report_poll) {
+        now_us = (poll + 1) * SIM_USB_POLL_US;
+        poll++;
+    }
+    key_report_poll = poll;
+}
+
+usb_hw_t *sim_usb_hw(void) {
+    static usb_hw_t usb;
+
+    usb.sof_rd = (now_us / SIM_USB_POLL_US) & USB_SOF_RD_BITS;
+    return &usb;
+}
+
+// ChibiOS drops reports while the host has not configured the device.
+static bool usb_configured(void) {
+    if (sim_usb_driver.state == USB_ACTIVE) {
+        return true;
+    }
+    sim_stats.dropped_reports++;
+    return false;
+}
+
+static void driver_send_keyboard(report_keyboard_t *report) {
+    (void)report;
+    if (!usb_configured()) {
+        return;
+    }
+    wait_for_poll();
+    sim_stats.key_reports++;
+}
+
+static void driver_send_nkro(report_nkro_t *report) {
+    (void)report;
+    if (!usb_configured()) {
+        return;
+    }
+    wait_for_poll();
+    sim_stats.key_reports++;
+}
+
+static void driver_send_mouse(report_mouse_t *report) {
+    if (!usb_configured()) {
+        return;
+    }
+    sim_stats.mouse_reports++;
+    sim_stats.wheel_units += report->v;
+}
+
+static void driver_send_extra(report_extra_t *report) {
+    (void)report;
+}
+
+static host_driver_t  sim_driver = {NULL, driver_send_keyboard, driver_send_nkro, driver_send_mouse, driver_send_extra};
+static host_driver_t *driver     = &sim_driver;
+
+host_driver_t *host_get_driver(void) {
+    return driver;
+}
+
+void host_set_driver(host_driver_t *new_driver) {
+    driver = new_driver;
+}
+
+static void send_keyboard_report(void) {
+    report_keyboard_t report = {.mods = report_mods};
+    uint8_t           slot   = 0;
+
+    for (uint8_t byte = 0; byte < sizeof(report_keys) && slot < sizeof(report.keys); byte++) {
+        for (uint8_t bits = report_keys[byte]; bits && slot < sizeof(report.keys); bits &= bits - 1) {
+            report.keys[slot++] = (uint8_t)(byte << 3 | __builtin_ctz(bits));
+        }
+    }
+    driver->send_keyboard(&report);
+}
+
+static void set_mods(uint8_t mods) {
+    if (mods != report_mods) {
+        report_mods = mods;
+        send_keyboard_report();
+    }
+}
+
+static void set_key(uint8_t code, bool on) {
+    uint8_t bit = (uint8_t)(1u << (code & 7));
+    bool    was = report_keys[code >> 3] & bit;
+
+    if (was == on) {
+        return;
+    }
+    if (on) {
+        report_keys[code >> 3] |= bit;
+    } else {
+        report_keys[code >> 3] &= (uint8_t)~bit;
+    }
+    send_keyboard_report();
+}
+
+void clear_keyboard(void) {
+    report_mods = 0;
+    memset(report_keys, 0, sizeof(report_keys));
+    send_keyboard_report();
+}
+
+static uint8_t mods_of(uint16_t keycode) {
+    return (keycode >= QK_MODS && keycode <= QK_MODS_MAX) ? (uint8_t)((keycode >> 8) & 0x0F) : 0;
+}
+
+void register_code16(uint16_t keycode) {
+    uint8_t code = keycode & 0xFF;
+
+    if (is_mouse_keycode(keycode)) {
+        report_mouse_t report = {.v = keycode == MS_WHLU ? 1 : keycode == MS_WHLD ? -1 : 0};
+        host_mouse_send(&report);
+        return;
+    }
+    if (code >= KC_LCTL && code <= KC_LGUI) {
+        set_mods(report_mods | (uint8_t)(1u << (code - KC_LCTL)));
+        return;
+    }
+    set_mods(report_mods | mods_of(keycode));
+    set_key(code, true);
+}
+
+void unregister_code16(uint16_t keycode) {
+    uint8_t code = keycode & 0xFF;
+
+    if (is_mouse_keycode(keycode)) {
+        report_mouse_t report = {0};
+        host_mouse_send(&report);
+        return;
+    }
+    if (code >= KC_LCTL && code <= KC_LGUI) {
+        set_mods(report_mods & (uint8_t)~(1u << (code - KC_LCTL)));
+        return;
+    }
+    set_key(code, false);
+    set_mods(report_mods & (uint8_t)~mods_of(keycode));
+}
+
+void register_code(uint8_t code) {
+    register_code16(code);
+}
+
+void unregister_code(uint8_t code) {
+    unregister_code16(code);
+}
+
+void register_mods(uint8_t mods) {
+    set_mods(report_mods | mods);
+}
+
+void unregister_mods(uint8_t mods) {
+    set_mods(report_mods & (uint8_t)~mods);
+}
+
+uint32_t eeconfig_read_user(void) {
+    return eeconfig_user;
+}
+
+void eeconfig_update_user(uint32_t value) {
+    eeconfig_user = value;
+    sim_stats.flash_writes++;
+    sim_advance_us(SIM_FLASH_WRITE_US);
+}
+
+report_mouse_t mousekey_get_report(void) {
+    return (report_mouse_t){0};
+}
+
+void host_mouse_send(report_mouse_t *report) {
+    driver->send_mouse(report);
+}
+
+void tap_code16(uint16_t keycode) {
+    register_code16(keycode);
+    unregister_code16(keycode);
+}
+
+// QMK's default lookup: the keymap in flash, or the EEPROM copy of it with
+// a dynamic keymap.
+__attribute__((weak)) uint16_t keymap_key_to_keycode(uint8_t layer, keypos_t key) {
+#ifdef DYNAMIC_KEYMAP_ENABLE
+    return dynamic_keymap_get_keycode(layer, key.row, key.col);
+#else
+    return keycode_at_keymap_location_raw(layer, key.row, key.col);
+#endif
+}
+
+// All keymaps here have DYNAMIC_KEYMAP_LAYER_COUNT layers (checked by
+// keymap_layers.h); QMK takes the count from sizeof(keymaps) in the keymap's
+// own translation unit.
+uint8_t keymap_layer_count(void) {
+    return DYNAMIC_KEYMAP_LAYER_COUNT;
+}
+
+uint16_t keycode_at_keymap_location_raw(uint8_t layer, uint8_t row, uint8_t col) {
+    if (layer < keymap_layer_count() && row < MATRIX_ROWS && col < MATRIX_COLS) {
+        return keymaps[layer][row][col];
+    }
+    return KC_TRNS;
+}
+
+// Replies go nowhere unless a harness listens.
+__attribute__((weak)) void raw_hid_send(uint8_t *data, uint8_t length) {
+    (void)data;
+    (void)length;
+}
+
+// Mirrors layer_switch_get_layer(): highest active layer whose entry is not
+// transparent.
+static uint8_t resolve_layer(keypos_t key) {
+    layer_state_t layers = layer_state | default_layer_state;
+
+    for (int8_t i = MAX_LAYER - 1; i >= 0; i--) {
+        if ((layers & ((layer_state_t)1 << i)) && keymap_key_to_keycode(i, key) != KC_TRNS) {
+            return (uint8_t)i;
+        }
+    }
+    return 0;
+}
+
+static void process_action(uint16_t keycode, bool pressed) {
+    if (keycode >= QK_MOMENTARY && keycode <= QK_MOMENTARY_MAX) {
+        if (pressed) {
+            layer_on(keycode & 0x1F);
+        } else {
+            layer_off(keycode & 0x1F);
+        }
+    } else if (keycode >= QK_TO && keycode < QK_MOMENTARY) {
+        if (pressed) {
+            layer_move(keycode & 0x1F);
+        }
+    } else if (keycode > KC_TRNS && keycode <= QK_MODS_MAX) {
+        if (pressed) {
+            register_code16(keycode);
+        } else {
+            unregister_code16(keycode);
+        }
+    }
+}
+
+// Wake-up edges for power.c: the matrix side of the sleep and the
+// semaphore it waits on.
+static uint64_t wake_at    = UINT64_MAX;
+static bool     wake_edges = true;
+static bool     wake_armed = false;
+
+void sim_wake_at(uint64_t us) {
+    wake_at = us;
+}
+
+void sim_wake_edges(bool on) {
+    wake_edges = on;
+}
+
+bool matrix_wake_arm(void) {
+    wake_armed = true;
+    return true;
+}
+
+void matrix_wake_disarm(void) {
+    wake_armed = false;
+}
+
+void chBSemObjectInit(binary_semaphore_t *bsp, bool taken) {
+    bsp->taken = taken;
+}
+
+void chBSemReset(binary_semaphore_t *bsp, bool taken) {
+    bsp->taken = taken;
+}
+
+void chBSemSignalI(binary_semaphore_t *bsp) {
+    bsp->taken = false;
+}
+
+msg_t chBSemWaitTimeout(binary_semaphore_t *bsp, sysinterval_t timeout) {
+    uint64_t deadline = now_us + (uint64_t)timeout * 1000;
+
+    if (bsp->taken && wake_armed && wake_edges && wake_at <= deadline) {
+        now_us  = MAX(now_us, wake_at);
+        wake_at = UINT64_MAX;
+#ifdef POWER_SAVE_ENABLE
+        power_wake_isr(NULL);
+#endif
+    }
+    if (!bsp->taken) {
+        bsp->taken = true;
+        return MSG_OK;
+    }
+    now_us = deadline;
+    return MSG_TIMEOUT;
+}
+
+uint32_t last_input_activity_elapsed(void) {
+    return timer_read32() - input_at;
+}
+
+void process_record(keyrecord_t *record) {
+    keypos_t key = record->event.key;
+
+    if (record->event.pressed) {
+        source_layer[key.row][key.col] = resolve_layer(key);
+    }
+
+    uint16_t keycode = keymap_key_to_keycode(source_layer[key.row][key.col], key);
+
+    if (process_record_kb(keycode, record)) {
+        process_action(keycode, record->event.pressed);
+    }
+}
+
+// No tap-hold keys in the keymaps: tapping passes every record straight on.
+void action_tapping_process(keyrecord_t record) {
+    process_record(&record);
+}
+
+void sim_key(uint8_t row, uint8_t col, bool pressed) {
+    keyrecord_t record = {.event = {.key = {.col = col, .row = row}, .pressed = pressed, .time = timer_read()}};
+    uint8_t     layer  = pressed ? resolve_layer(record.event.key) : source_layer[row][col];
+
+    input_at = timer_read32();
+
+    // The matrix and debounce are not modelled: the change is seen and
+    // accepted in the same scan.
+    TRACE(TRACE_MATRIX, row << 8 | (pressed ? 1u << col : 0));
+    TRACE(TRACE_DEBOUNCE, row << 8 | (pressed ? 1u << col : 0));
+
+    // action_exec() only has the pre-process step with these two.
+#if defined(COMBO_ENABLE) || defined(REPEAT_KEY_ENABLE)
+    if (!pre_process_record_kb(keymap_key_to_keycode(layer, record.event.key), &record)) {
+        return;
+    }
+#else
+    (void)layer;
+#endif
+    action_tapping_process(record);
+}
+
+void sim_encoder(bool clockwise) {
+    input_at = timer_read32();
+    encoder_update_kb(0, clockwise);
+}
+
+void sim_scan(void) {
+    matrix_scan_kb();
+    housekeeping_task_kb();
+}
+
+void sim_reset_stats(void) {
+    memset(&sim_stats, 0, sizeof(sim_stats));
+}
+
+void sim_init(void) {
+    now_us              = 0;
+    layer_state         = 0;
+    default_layer_state = 1;
+    report_mods         = 0;
+    key_report_poll     = UINT64_MAX;
+    input_at            = 0;
+    driver              = &sim_driver;
+    rgb_enabled         = true;
+    memset(report_keys, 0, sizeof(report_keys));
+    memset(source_layer, 0, sizeof(source_layer));
+    memset(strip, 0, sizeof(strip));
+    sim_usb_driver.state = USB_ACTIVE;
+    wake_at              = UINT64_MAX;
+    wake_edges           = true;
+    for (uint8_t i = 0; i < SIM_PIN_COUNT; i++) {
+        pins[i] = true;
+    }
+#ifdef VIA_ENABLE
+    via_init();
+#endif
+    keyboard_post_init_kb();
+    sim_reset_stats();
+}
+
+// Weak defaults, as provided by the QMK core.
+
+__attribute__((weak)) void keyboard_pre_init_user(void) {}
+
+__attribute__((weak)) void keyboard_post_init_kb(void) {
+    keyboard_post_init_user();
+}
+
+__attribute__((weak)) void keyboard_post_init_user(void) {}
+
+__attribute__((weak)) void matrix_scan_kb(void) {
+    matrix_scan_user();
+}
+
+__attribute__((weak)) void matrix_scan_user(void) {}
+
+__attribute__((weak)) void housekeeping_task_kb(void) {
+    housekeeping_task_user();
+}
+
+__attribute__((weak)) void housekeeping_task_user(void) {}
+
+__attribute__((weak)) void eeconfig_init_kb(void) {
+    eeconfig_init_user();
+}
+
+__attribute__((weak)) void eeconfig_init_user(void) {}
+
+__attribute__((weak)) void suspend_power_down_kb(void) {
+    suspend_power_down_user();
+}
+
+__attribute__((weak)) void suspend_power_down_user(void) {}
+
+__attribute__((weak)) void suspend_wakeup_init_kb(void) {
+    suspend_wakeup_init_user();
+}
+
+__attribute__((weak)) void suspend_wakeup_init_user(void) {}
+
+__attribute__((weak)) bool pre_process_record_kb(uint16_t keycode, keyrecord_t *record) {
+    return pre_process_record_user(keycode, record);
+}
+
+__attribute__((weak)) bool pre_process_record_user(uint16_t keycode, keyrecord_t *record) {
+    (void)keycode;
+    (void)record;
+    return true;
+}
+
+__attribute__((weak)) bool process_record_kb(uint16_t keycode, keyrecord_t *record) {
+    return process_record_user(keycode, record);
+}
+
+__attribute__((weak)) bool process_record_user(uint16_t keycode, keyrecord_t *record) {
+    (void)keycode;
+    (void)record;
+    return true;
+}
+
+__attribute__((weak)) layer_state_t layer_state_set_kb(layer_state_t state) {
+    return layer_state_set_user(state);
+}
+
+__attribute__((weak)) layer_state_t layer_state_set_user(layer_state_t state) {
+    return state;
+}
+
+__attribute__((weak)) layer_state_t default_layer_state_set_kb(layer_state_t state) {
+    return default_layer_state_set_user(state);
+}
+
+__attribute__((weak)) layer_state_t default_layer_state_set_user(layer_state_t state) {
+    return state;
+}
+
+__attribute__((weak)) bool encoder_update_kb(uint8_t index, bool clockwise) {
+    return encoder_update_user(index, clockwise);
+}
+
+__attribute__((weak)) bool encoder_update_user(uint8_t index, bool clockwise) {
+    (void)index;
+    (void)clockwise;
+    return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+// Host simulator driver API. The simulator stands in for the QMK core loop:
+// it resolves keycodes through the keymap layers, feeds process_record_*,
+// tracks the HID report state and counts everything that would cost time on
+// the RP2040 (reports sent, rgblight calls, WS2812 frames pushed).
+
+#include "quantum.h"
+
+// Modeled cost of one WS2812 frame: 24 bits at 1.25 us per LED plus reset.
+#define SIM_WS2812_FRAME_US (RGBLIGHT_LED_COUNT * 24 * 5 / 4 + 280)
+
+// Modeled XIP stall of one wear-leveling write: programming a 256-byte
+// page. The occasional 4 KiB sector erase (~50 ms) is not included.
+#define SIM_FLASH_WRITE_US 1000
+
+// USB poll interval of the keyboard endpoint. A report sent while the
+// previous one has not been collected yet blocks until the next poll, as
+// the ChibiOS driver does.
+#define SIM_USB_POLL_US 1000
+
+typedef struct {
+    uint32_t key_reports;
+    uint32_t mouse_reports;
+    int32_t  wheel_units;
+    uint32_t rgb_calls;
+    uint32_t led_frames;
+    uint32_t flash_writes;
+    uint32_t dropped_reports;
+} sim_stats_t;
+
+extern sim_stats_t sim_stats;
+
+void     sim_init(void);
+void     sim_reset_stats(void);
+uint64_t sim_now_us(void);
+void     sim_advance_us(uint32_t us);
+void     sim_set_pin(pin_t pin, bool level);
+void     sim_key(uint8_t row, uint8_t col, bool pressed);
+void     sim_encoder(bool clockwise);
+void     sim_scan(void);
+uint8_t  sim_strip_lit(void);
+// R, G, B last written to the LED through the WS2812 driver.
+const uint8_t *sim_strip_led(uint8_t index);
+// Schedules a key or encoder edge. While the matrix is armed for wake-ups a
+// sleep ends there; with edges off it sleeps its full time regardless.
+void     sim_wake_at(uint64_t us);
+void     sim_wake_edges(bool on);
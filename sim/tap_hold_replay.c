@@ -0,0 +1,210 @@
+// Replays a corpus of recorded-style key streams through the default keymap
+// with the tap-hold keys of tap_hold.def and checks what reaches the host.
+// Every event that should produce a key names it; the harness checks the
+// keys come out in order and measures how long after its event each one
+// appears. A keycode with modifiers sends the modifier report first, so its
+// key comes one USB poll (1000 us) later with or without tap-hold. The last
+// column is what QMK's standard tap-hold would add: a key pressed while a
+// tap-hold key is undecided waits for its release or the term.
+//   make taphold
+// runs it twice: on tap_hold.def, and on tap_hold_speculative.def
+// (TAP_HOLD_DEF) with the TAP_HOLD_SPECULATIVE_CORPUS streams, which check
+// the speculative comma: sent in the scan of the press, taken back exactly
+// once by a hold.
+
+#include <stdio.h>
+#include <string.h>
+#include "sim.h"
+#include "tap_hold.h"
+
+#ifndef TAP_HOLD_DEF
+#    define TAP_HOLD_DEF "tap_hold.def"
+#endif
+
+#define MAX_EVENTS 64
+#define MAX_DOWNS 64
+#define FLUSH_MS 300
+
+typedef struct {
+    uint16_t at_ms;
+    uint8_t  row;
+    uint8_t  col;
+    bool     pressed;
+    uint8_t  expect;  // key that must appear in the report, 0 for none
+} event_t;
+
+typedef struct {
+    const char   *name;
+    const event_t events[MAX_EVENTS];
+} stream_t;
+
+#define P(ms, row, col, expect) {ms, row, col, true, expect}
+#define R(ms, row, col) {ms, row, col, false, 0}
+#define RT(ms, row, col, expect) {ms, row, col, false, expect}
+#define END {UINT16_MAX, 0, 0, false, 0}
+
+static const stream_t corpus[] = {
+#ifdef TAP_HOLD_SPECULATIVE_CORPUS
+    // The comma goes out at the press of MO(4), ahead of the digits.
+    {"comma_at_press", {P(0, 4, 2, KC_P3), R(60, 4, 2), P(90, 0, 2, KC_COMM), R(140, 0, 2), P(160, 3, 1, KC_P5), R(210, 3, 1), END}},
+    // Hold MO(4) for an RGB key: the comma is taken back once.
+    {"rgb_retracts", {P(0, 0, 2, KC_COMM), P(100, 1, 2, TAP_HOLD_RETRACT), R(150, 1, 2), R(300, 0, 2), END}},
+    // Held past the term: taken back at the release.
+    {"long_retracts", {P(0, 0, 2, KC_COMM), RT(400, 0, 2, TAP_HOLD_RETRACT), P(450, 4, 0, KC_P1), R(500, 4, 0), END}},
+    // TAB stays sent at the release.
+    {"tab_unchanged", {P(0, 0, 1, 0), RT(60, 0, 1, KC_TAB), P(80, 4, 0, KC_P1), R(130, 4, 0), END}},
+#else
+    // 12.5+7 with overlapping digits, the usual way fast entry rolls.
+    {"digits", {P(0, 4, 0, KC_P1), P(45, 4, 1, KC_P2), R(60, 4, 0), R(100, 4, 1), P(130, 5, 2, KC_PDOT), R(190, 5, 2), P(220, 3, 1, KC_P5), R(280, 3, 1), P(300, 2, 3, KC_PPLS), P(340, 2, 0, KC_P7), R(350, 2, 3), R(420, 2, 0), P(450, 4, 3, KC_PENT), R(500, 4, 3), END}},
+    // Spreadsheet entry: a number, TAB on the MO(1) key, the next number.
+    {"tab_cells", {P(0, 4, 0, KC_P1), R(50, 4, 0), P(70, 4, 1, KC_P2), R(120, 4, 1), P(150, 0, 1, 0), RT(210, 0, 1, KC_TAB), P(220, 3, 1, KC_P5), R(270, 3, 1), P(290, 5, 1, KC_P0), R(340, 5, 1), P(370, 0, 1, 0), RT(420, 0, 1, KC_TAB), P(425, 2, 2, KC_P9), R(480, 2, 2), END}},
+    // Decimal comma on the MO(4) key, sent at the release.
+    {"comma_decimal", {P(0, 4, 2, KC_P3), R(60, 4, 2), P(90, 0, 2, 0), RT(140, 0, 2, KC_COMM), P(160, 3, 1, KC_P5), R(210, 3, 1), P(240, 3, 1, KC_P5), R(290, 3, 1), END}},
+    // Hold MO(1) for copy: no TAB.
+    {"layer_shortcut", {P(0, 0, 1, 0), P(120, 2, 3, KC_C), R(180, 2, 3), R(250, 0, 1), P(300, 4, 0, KC_P1), R(350, 4, 0), END}},
+    // Hold MO(4) for an RGB key: no comma.
+    {"layer_rgb", {P(0, 0, 2, 0), P(100, 1, 2, 0), R(150, 1, 2), R(300, 0, 2), END}},
+    // Held past the term with nothing pressed: no TAB.
+    {"long_hold", {P(0, 0, 1, 0), R(400, 0, 1), P(450, 4, 0, KC_P1), R(500, 4, 0), END}},
+    // A digit pressed before MO(1) is released counts as a hold, as with
+    // plain MO(): layer 1 has LCTL(KC_S) there.
+    {"overlap_is_hold", {P(0, 0, 1, 0), P(50, 3, 1, KC_S), R(80, 0, 1), R(120, 3, 1), END}},
+#endif
+};
+
+typedef struct {
+    uint8_t  code;
+    uint64_t at_us;
+} down_t;
+
+static host_driver_t *sim_driver;
+static host_driver_t  capture;
+static uint8_t        shown[6];
+static down_t         downs[MAX_DOWNS];
+static uint8_t        down_count;
+
+static bool in(const uint8_t *keys, uint8_t code) {
+    for (uint8_t i = 0; i < 6; i++) {
+        if (keys[i] == code) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void capture_keyboard(report_keyboard_t *report) {
+    sim_driver->send_keyboard(report);
+    for (uint8_t i = 0; i < 6; i++) {
+        if (report->keys[i] && !in(shown, report->keys[i]) && down_count < MAX_DOWNS) {
+            downs[down_count++] = (down_t){report->keys[i], sim_now_us()};
+        }
+    }
+    memcpy(shown, report->keys, sizeof(shown));
+}
+
+static bool tap_hold_key(uint8_t row, uint8_t col, uint16_t *term, uint8_t *flags_out) {
+#define TAP_HOLD(r, c, tap, term_ms, flags) \
+    if (row == r && col == c) {             \
+        *term      = term_ms;               \
+        *flags_out = flags;                 \
+        return true;                        \
+    }
+#include TAP_HOLD_DEF
+#undef TAP_HOLD
+    return false;
+}
+
+// QMK's standard tap-hold: the event waits while a tap-hold key pressed
+// before it is still down and within its term.
+static uint32_t standard_delay_ms(const event_t *events, uint8_t index) {
+    uint32_t delay = 0;
+
+    for (uint8_t i = 0; i < index; i++) {
+        uint16_t term;
+        uint8_t  flags;
+        if (!events[i].pressed || !tap_hold_key(events[i].row, events[i].col, &term, &flags)) {
+            continue;
+        }
+        uint32_t decided = events[i].at_ms + term;
+        for (uint8_t j = i + 1; events[j].at_ms != UINT16_MAX; j++) {
+            if (!events[j].pressed && events[j].row == events[i].row && events[j].col == events[i].col) {
+                decided = MIN(decided, events[j].at_ms);
+                break;
+            }
+        }
+        if (decided > events[index].at_ms) {
+            delay = MAX(delay, decided - events[index].at_ms);
+        }
+    }
+    return delay;
+}
+
+static void scan_until(uint64_t us) {
+    while (sim_now_us() + 1000 <= us) {
+        sim_advance_us(1000);
+        sim_scan();
+    }
+}
+
+static bool replay(const stream_t *stream, uint32_t *added_us, uint32_t *standard_ms) {
+    const event_t *events = stream->events;
+    uint64_t       at[MAX_EVENTS];
+    uint8_t        count = 0;
+
+    sim_init();
+    sim_driver            = host_get_driver();
+    capture               = *sim_driver;
+    capture.send_keyboard = capture_keyboard;
+    host_set_driver(&capture);
+    memset(shown, 0, sizeof(shown));
+    down_count = 0;
+
+    for (; events[count].at_ms != UINT16_MAX; count++) {
+        scan_until((uint64_t)events[count].at_ms * 1000);
+        at[count] = sim_now_us();
+        sim_key(events[count].row, events[count].col, events[count].pressed);
+    }
+    scan_until(sim_now_us() + FLUSH_MS * 1000);
+    host_set_driver(sim_driver);
+
+    uint8_t next = 0;
+    bool    ok   = true;
+    *added_us    = 0;
+    *standard_ms = 0;
+    for (uint8_t i = 0; i < count; i++) {
+        if (!events[i].expect) {
+            continue;
+        }
+        if (next >= down_count || downs[next].code != events[i].expect) {
+            ok = false;
+            break;
+        }
+        uint32_t added = (uint32_t)(downs[next].at_us - at[i]);
+        uint16_t term;
+        uint8_t  flags;
+        // A speculative tap goes out in the scan of its press.
+        if (events[i].pressed && tap_hold_key(events[i].row, events[i].col, &term, &flags) && (flags & TAP_HOLD_SPECULATIVE) && added) {
+            ok = false;
+            break;
+        }
+        *added_us = MAX(*added_us, added);
+        if (events[i].pressed) {
+            *standard_ms = MAX(*standard_ms, standard_delay_ms(events, i));
+        }
+        next++;
+    }
+    return ok && next == down_count;
+}
+
+int main(void) {
+    uint32_t bad = 0;
+
+    printf("%-16s %8s %14s %18s\n", "stream", "output", "max_added_us", "standard_added_ms");
+    for (uint8_t i = 0; i < ARRAY_SIZE(corpus); i++) {
+        uint32_t added_us, standard_ms;
+        bool     ok = replay(&corpus[i], &added_us, &standard_ms);
+        printf("%-16s %8s %14u %18u\n", corpus[i].name, ok ? "ok" : "WRONG", added_us, standard_ms);
+        bad += !ok;
+    }
+    return bad ? 1 : 0;
+}
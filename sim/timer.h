@@ -0,0 +1,18 @@
+#pragma once
+
+// Host-side timer: driven by the simulator clock, not wall time, so replays
+// are deterministic.
+
+#include <stdint.h>
+
+uint16_t timer_read(void);
+uint32_t timer_read32(void);
+uint16_t timer_elapsed(uint16_t last);
+uint32_t timer_elapsed32(uint32_t last);
+
+#define TIMER_DIFF_16(a, b) ((uint16_t)((a) - (b)))
+
+typedef uint32_t fast_timer_t;
+
+fast_timer_t timer_read_fast(void);
+fast_timer_t timer_elapsed_fast(fast_timer_t last);
@@ -0,0 +1,87 @@
+// Runs a typing and layer-switching session through the default keymap with
+// LATENCY_TRACE_ENABLE, reads the ring out through the raw HID command the
+// way a host would, and prints every reply packet as one hex line:
+//   ./build/trace_dump | ../tools/trace_decode.py --input -
+// and ends with the loop statistics (no XIP cache here, so no accesses).
+// Times come from the simulator clock, so only the scan-paced stages (RGB
+// refresh, wheel batching) show non-zero latency.
+
+#include <stdio.h>
+#include "sim.h"
+#include "host_cmd.h"
+#include "raw_hid.h"
+#include "rgb_store.h"
+#include "hardware/structs/xip_ctrl.h"
+
+#define SCAN_US 1000
+#define PACKET 32
+
+xip_ctrl_hw_t sim_xip_ctrl;
+
+static bool drained;
+
+void raw_hid_send(uint8_t *data, uint8_t length) {
+    for (uint8_t i = 0; i < length; i++) {
+        printf("%02x", data[i]);
+    }
+    printf("\n");
+    drained = data[0] == HOST_CMD_ID && data[1] == HOST_CMD_TRACE_READ && data[2] == 0;
+}
+
+static void step(void) {
+    sim_advance_us(SCAN_US);
+    sim_scan();
+}
+
+static void tap(uint8_t row, uint8_t col) {
+    sim_key(row, col, true);
+    step();
+    sim_key(row, col, false);
+    step();
+}
+
+static void read_out(void) {
+    drained = false;
+    while (!drained) {
+        uint8_t packet[PACKET] = {HOST_CMD_ID, HOST_CMD_TRACE_READ};
+        raw_hid_receive(packet, sizeof(packet));
+    }
+}
+
+int main(void) {
+    sim_init();
+    step();
+
+    for (uint8_t round = 0; round < 20; round++) {
+        tap(2, 0);
+        tap(2, 1);
+        tap(3, 2);
+        for (uint8_t i = 0; i < 5; i++) {
+            step();
+        }
+        tap(0, 1);
+        for (uint8_t i = 0; i < 15; i++) {
+            step();
+        }
+        for (uint8_t i = 0; i < 3; i++) {
+            sim_encoder(true);
+            step();
+        }
+        // A host polling every few ms keeps the ring from overflowing.
+        read_out();
+    }
+
+    // One brightness step on MO(4), then idle until the RGB store writes.
+    sim_key(0, 2, true);
+    step();
+    tap(2, 0);
+    sim_key(0, 2, false);
+    for (uint16_t i = 0; i <= RGB_STORE_QUIET_MS; i++) {
+        step();
+    }
+    read_out();
+
+    uint8_t packet[PACKET] = {HOST_CMD_ID, HOST_CMD_LOOP_STATS};
+    raw_hid_receive(packet, sizeof(packet));
+    return 0;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+// ChibiOS USB driver state, as far as the keyboard code reads it.
+
+typedef enum {
+    USB_UNINIT,
+    USB_STOP,
+    USB_READY,
+    USB_SELECTED,
+    USB_ACTIVE,
+    USB_SUSPENDED,
+} usbstate_t;
+
+typedef struct {
+    usbstate_t state;
+} USBDriver;
+
+// sim_init() leaves it USB_ACTIVE; harnesses can hold enumeration back.
+extern USBDriver sim_usb_driver;
+#define USB_DRIVER sim_usb_driver
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Command ids as in QMK's via.h.
+enum via_command_id {
+    id_dynamic_keymap_get_keycode = 0x04,
+    id_dynamic_keymap_set_keycode = 0x05,
+    id_dynamic_keymap_reset       = 0x06,
+    id_eeprom_reset               = 0x0A,
+    id_dynamic_keymap_get_buffer  = 0x12,
+    id_dynamic_keymap_set_buffer  = 0x13,
+    id_unhandled                  = 0xFF,
+};
+
+void via_init(void);
+void eeconfig_init_via(void);
+bool via_command_kb(uint8_t *data, uint8_t length);
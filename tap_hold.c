@@ -0,0 +1,110 @@
+// Tap-hold without added latency. QMK's tap-hold holds back the tap-hold
+// key and every key pressed after it until the release or TAPPING_TERM
+// decides between tap and hold, which delays the digits that follow.
+// On these keys the hold is a layer, which sends nothing by itself, so it
+// can start at the press: a key pressed meanwhile commits the hold and is
+// processed on the layer right away, as with plain MO(). Only a clean tap
+// is left, and it is known at the release, where it is sent.
+//
+// A speculative key sends its tap at the press already and takes it back
+// with TAP_HOLD_RETRACT when it turns into a hold.
+
+#include "quantum.h"
+#include "tap_hold.h"
+#include "macro_seq.h"
+#include "hot_path.h"
+
+// The table; make -C sim taphold also builds with sim/tap_hold_speculative.def.
+#ifndef TAP_HOLD_DEF
+#    define TAP_HOLD_DEF "tap_hold.def"
+#endif
+
+typedef struct {
+    uint8_t  row;
+    uint8_t  col;
+    uint16_t tap;
+    uint16_t term;
+    uint8_t  flags;
+} tap_hold_key_t;
+
+static const tap_hold_key_t keys[] = {
+#define TAP_HOLD(row, col, tap, term, flags) {row, col, tap, term, flags},
+#include TAP_HOLD_DEF
+#undef TAP_HOLD
+};
+
+typedef struct {
+    bool     down;
+    bool     hold;
+    uint8_t  layer;
+    uint16_t pressed_at;
+} tap_hold_state_t;
+
+// One backspace only takes back one typed character.
+#define TYPES_ONE_CHAR(keycode) (((keycode) >= KC_A && (keycode) <= KC_0) || ((keycode) >= KC_SPACE && (keycode) <= KC_SLASH))
+
+#define TAP_HOLD(row, col, tap, term, flags) _Static_assert(!((flags) & TAP_HOLD_SPECULATIVE) || TYPES_ONE_CHAR(tap), "a speculative tap must type a single character, see tap_hold.def");
+#include TAP_HOLD_DEF
+#undef TAP_HOLD
+
+static tap_hold_state_t state[ARRAY_SIZE(keys)];
+
+static int8_t find(keypos_t pos) {
+    for (uint8_t i = 0; i < ARRAY_SIZE(keys); i++) {
+        if (keys[i].row == pos.row && keys[i].col == pos.col) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// The press report goes out with the event; the release follows from the
+// main loop, so the tap costs no wait for the next USB poll.
+static void send_tap(uint16_t keycode) {
+    macro_step_t release = SEQ_UP(keycode);
+
+    register_code16(keycode);
+    macro_seq_play(&release, 1);
+}
+
+static void commit_hold(uint8_t i) {
+    state[i].hold = true;
+    if (keys[i].flags & TAP_HOLD_SPECULATIVE) {
+        tap_code16(TAP_HOLD_RETRACT);
+    }
+}
+
+bool HOT_PATH(tap_hold_process)(uint16_t keycode, keyrecord_t *record) {
+    int8_t i = find(record->event.key);
+
+    if (record->event.pressed) {
+        // Any other key decides every undecided tap-hold key.
+        for (uint8_t k = 0; k < ARRAY_SIZE(keys); k++) {
+            if (k != i && state[k].down && !state[k].hold) {
+                commit_hold(k);
+            }
+        }
+        if (i < 0 || keycode < QK_MOMENTARY || keycode > QK_MOMENTARY_MAX) {
+            return true;
+        }
+        state[i] = (tap_hold_state_t){.down = true, .layer = keycode & 0x1F, .pressed_at = record->event.time};
+        layer_on(state[i].layer);
+        if (keys[i].flags & TAP_HOLD_SPECULATIVE) {
+            send_tap(keys[i].tap);
+        }
+        return false;
+    }
+
+    if (i < 0 || !state[i].down) {
+        return true;
+    }
+    state[i].down = false;
+    layer_off(state[i].layer);
+    if (!state[i].hold && TIMER_DIFF_16(record->event.time, state[i].pressed_at) >= keys[i].term) {
+        commit_hold(i);
+    }
+    if (!state[i].hold && !(keys[i].flags & TAP_HOLD_SPECULATIVE)) {
+        send_tap(keys[i].tap);
+    }
+    return false;
+}
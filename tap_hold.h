@@ -0,0 +1,22 @@
+#pragma once
+
+#include "quantum.h"
+
+// Tap-hold for the MO() keys listed in tap_hold.def. The layer turns on at
+// the press, so keys pressed meanwhile are never held back; a release with
+// no key pressed in between and within the term sends the tap keycode.
+
+// Sent to take back a speculative tap once the key turns out to be a hold.
+#ifndef TAP_HOLD_RETRACT
+#    define TAP_HOLD_RETRACT KC_BSPC
+#endif
+
+enum tap_hold_flags {
+    // Send the tap at the press instead of the release, and retract it with
+    // TAP_HOLD_RETRACT if the key becomes a hold. Only for taps that type a
+    // single character.
+    TAP_HOLD_SPECULATIVE = 1 << 0,
+};
+
+// From process_record_kb(). Returns false for the events it handles itself.
+bool tap_hold_process(uint16_t keycode, keyrecord_t *record);
@@ -0,0 +1,208 @@
+#!/usr/bin/env python3
+"""Generate the keymap and layer LED tables from layers.json and
+keyboard.json.
+
+layers.json lists every layer once: its name, its RGB entry and its keys in
+the order of the layout. keyboard.json stays the source for the matrix, the
+layout and the LED count. Out of the two come
+    keymap_layers.h        the keymaps[] table of the three keymaps, and
+                           compile-time checks of config.h and the simulator
+                           against keyboard.json
+    rgb_layers.def         the per-layer RGB table of rgb_effect.c
+    profiles/numpad.json   the built-in keymap as a profile (tools/profiles.py)
+
+    tools/gen_tables.py            # rewrite what changed
+    tools/gen_tables.py --check    # fail if anything is stale or disagrees
+    make -C sim tables             # --check and build every keymap
+
+--check also compares keymaps/via/vial.json with keyboard.json.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+
+from profiles import PROFILE_NAME_LEN, ROOT, custom_keycodes, keycode, load_keyboard
+
+HEADER = "Generated by tools/gen_tables.py from %s, do not edit."
+
+
+def path(*parts):
+    return os.path.join(ROOT, *parts)
+
+
+def load_json(*parts):
+    with open(path(*parts)) as f:
+        return json.load(f)
+
+
+def effects():
+    with open(path("rgb_effect.h")) as f:
+        source = f.read()
+    body = re.search(r"enum\s+rgb_effect\s*{(.*?)}", source, re.S).group(1)
+    return [name for name in re.findall(r"RGB_EFFECT_(\w+)", body) if name != "COUNT"]
+
+
+def validate(spec, positions, custom):
+    errors = []
+    known = effects()
+    for number, layer in enumerate(spec["layers"]):
+        where = "layer %d (%s)" % (number, layer["name"])
+        if len(layer["keys"]) != len(positions):
+            errors.append("%s: %d keys, %s has %d" % (where, len(layer["keys"]), spec["layout"], len(positions)))
+        for key in layer["keys"]:
+            try:
+                keycode(key, custom)
+            except ValueError as error:
+                errors.append("%s: %s" % (where, error))
+        rgb = layer["rgb"]
+        if rgb["effect"] not in known:
+            errors.append("%s: effect %s is not one of %s" % (where, rgb["effect"], ", ".join(known)))
+        for field in ("hue", "speed", "spread"):
+            if not 0 <= rgb[field] <= 255:
+                errors.append("%s: %s out of 0..255" % (where, field))
+    return errors
+
+
+def keymap_layers(spec, keyboard, rows, cols, positions):
+    pins = len(keyboard["matrix_pins"]["rows"])
+    virtual = [(row, col) for row, col in positions if row >= pins]
+    count = len(spec["layers"])
+    out = [
+        "// " + HEADER % "layers.json and keyboard.json",
+        "// Included once, by keymap.c, after its custom keycodes.",
+        "",
+        "#pragma once",
+        "",
+        "#define KEYMAP_LAYER_COUNT %d" % count,
+        "",
+        "// The copies in config.h and the simulator.",
+        '_Static_assert(MATRIX_ROWS == %d && MATRIX_COLS == %d, "matrix size differs from keyboard.json");' % (rows, cols),
+        "#ifdef RGBLIGHT_LED_COUNT",
+        '_Static_assert(RGBLIGHT_LED_COUNT == %d, "RGBLIGHT_LED_COUNT differs from keyboard.json");' % keyboard["rgblight"]["led_count"],
+        "#endif",
+        "#ifdef DYNAMIC_KEYMAP_LAYER_COUNT",
+        '_Static_assert(DYNAMIC_KEYMAP_LAYER_COUNT == KEYMAP_LAYER_COUNT, "DYNAMIC_KEYMAP_LAYER_COUNT differs from layers.json");',
+        "#endif",
+        "#ifdef LAYER_STATE_8BIT",
+        '_Static_assert(KEYMAP_LAYER_COUNT <= 8, "LAYER_STATE_8BIT holds 8 layers");',
+        "#endif",
+    ]
+    if len(virtual) == 1:
+        out += [
+            "#ifdef ENCODER_BTN_ROW",
+            '_Static_assert(ENCODER_BTN_ROW == %d && ENCODER_BTN_COL == %d, "the encoder button is not the layout\'s key past the matrix pins");' % virtual[0],
+            "#endif",
+        ]
+    out += ["", "const uint16_t PROGMEM keymaps[KEYMAP_LAYER_COUNT][MATRIX_ROWS][MATRIX_COLS] = {"]
+    for number, layer in enumerate(spec["layers"]):
+        keys = [key + "," for key in layer["keys"][:-1]] + [layer["keys"][-1]]
+        width = max(len(key) for key in keys) + 2
+        width += -width % 4
+        out.append("    // %s" % layer["name"])
+        out.append("    [%d] = %s(" % (number, spec["layout"]))
+        for first in range(0, len(keys), cols):
+            out.append("        " + "".join(key.ljust(width) for key in keys[first : first + cols]).rstrip())
+        out.append("    ),")
+    out.append("};")
+    return "\n".join(out) + "\n"
+
+
+def rgb_layers(spec):
+    out = [
+        "// " + HEADER % "layers.json",
+        "//",
+        "// Per-layer RGB, expanded into a const table by rgb_effect.c:",
+        "//",
+        "//   RGB_LAYER(layer, hue, effect, speed, spread)",
+        "//     hue     base colour; RGB_UI_HUI/HUD shift it at runtime",
+        "//     effect  %s or %s" % (", ".join(effects()[:-1]), effects()[-1]),
+        "//     speed   animation phase steps per 16 ms (256 steps per cycle)",
+        "//     spread  phase offset from one LED to the next",
+        "//",
+        "// Saturation and brightness come from the RGB_UI keys. Layers not listed",
+        "// use layer 0's entry. Effects only animate in the \"layer\" mode of",
+        "// rgb_modes[] (RGB_EFFECT_ENABLE); the other modes just take the hue.",
+        "",
+    ]
+    for number, layer in enumerate(spec["layers"]):
+        rgb = layer["rgb"]
+        out.append("RGB_LAYER(%d, %d, %s, %d, %d)" % (number, rgb["hue"], rgb["effect"], rgb["speed"], rgb["spread"]))
+    return "\n".join(out) + "\n"
+
+
+def numpad_profile(spec, cols):
+    out = ["{", '    "name": "%s",' % spec["layers"][0]["name"], '    "layout": "%s",' % spec["layout"], '    "layers": [']
+    for number, layer in enumerate(spec["layers"]):
+        keys = ['"%s"' % key for key in layer["keys"]]
+        lines = [", ".join(keys[first : first + cols]) for first in range(0, len(keys), cols)]
+        out.append("        [")
+        out.append(",\n".join("            " + line for line in lines))
+        out.append("        ]" + ("," if number < len(spec["layers"]) - 1 else ""))
+    out += ["    ]", "}"]
+    return "\n".join(out) + "\n"
+
+
+def check_vial(keyboard, rows, cols, positions):
+    vial = load_json("keymaps", "via", "vial.json")
+    errors = []
+    if (vial["matrix"]["rows"], vial["matrix"]["cols"]) != (rows, cols):
+        errors.append("vial.json: matrix %dx%d, keyboard.json %dx%d" % (vial["matrix"]["rows"], vial["matrix"]["cols"], rows, cols))
+    for field, usb in (("vendorId", "vid"), ("productId", "pid")):
+        if int(vial[field], 16) != int(keyboard["usb"][usb], 16):
+            errors.append("vial.json: %s %s, keyboard.json %s" % (field, vial[field], keyboard["usb"][usb]))
+    labels = sorted(tuple(int(n) for n in key.split(",")) for row in vial["layouts"]["keymap"] for key in row if isinstance(key, str))
+    if labels != sorted(tuple(p) for p in positions):
+        errors.append("vial.json: keys %s, keyboard.json layout %s" % (labels, sorted(tuple(p) for p in positions)))
+    return errors
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--check", action="store_true", help="change nothing, exit 1 if a file is stale or disagrees")
+    args = parser.parse_args()
+
+    spec = load_json("layers.json")
+    keyboard = load_json("keyboard.json")
+    rows, cols, layouts = load_keyboard()
+    positions = layouts[spec["layout"]]
+    custom = custom_keycodes(path("keymaps", "default", "keymap.c"))
+
+    errors = validate(spec, positions, custom)
+    if len(spec["layers"][0]["name"].encode()) > PROFILE_NAME_LEN:
+        errors.append("layer 0: name longer than %d bytes, it names the profile" % PROFILE_NAME_LEN)
+    if errors:
+        sys.exit("\n".join(errors))
+
+    outputs = {
+        "keymap_layers.h": keymap_layers(spec, keyboard, rows, cols, positions),
+        "rgb_layers.def": rgb_layers(spec),
+        os.path.join("profiles", "numpad.json"): numpad_profile(spec, cols),
+    }
+    stale = []
+    for name, text in outputs.items():
+        try:
+            with open(path(name)) as f:
+                current = f.read()
+        except FileNotFoundError:
+            current = None
+        if current == text:
+            continue
+        stale.append(name)
+        if not args.check:
+            with open(path(name), "w") as f:
+                f.write(text)
+            print("wrote %s" % name)
+
+    if args.check:
+        errors = ["%s is stale, run tools/gen_tables.py" % name for name in stale]
+        errors += check_vial(keyboard, rows, cols, positions)
+        if errors:
+            sys.exit("\n".join(errors))
+        print("%d layers, %d keys, %d LEDs: generated tables and vial.json agree with the sources" % (len(spec["layers"]), len(positions), keyboard["rgblight"]["led_count"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+"""Stream LED frames to the keyboard over raw HID (rgb_stream.h) and print
+what it showed.
+
+Build with RGB_STREAM_ENABLE=yes, then
+    tools/led_stream.py --fps 100 --seconds 10   # rainbow running along the strip
+    tools/led_stream.py --colour ff8000          # one colour until Ctrl-C
+    tools/led_stream.py --stats                  # counters only
+    make -C sim stream                           # simulated loopback
+
+The keyboard goes back to its own lighting RGB_STREAM_TIMEOUT_MS (1 s)
+after the last frame. Needs the hidapi module (pip install hid).
+"""
+
+import argparse
+import colorsys
+import json
+import os
+import struct
+import time
+
+from trace_decode import HOST_CMD_ID, PACKET, command, default_ids, open_device
+
+HOST_CMD_LED_FRAME = 0x07
+HOST_CMD_LED_STATS = 0x08
+SHOW = 0x80
+LEDS_PER_PACKET = 9
+
+
+def send_frame(device, number, colours):
+    for first in range(0, len(colours), LEDS_PER_PACKET):
+        chunk = colours[first : first + LEDS_PER_PACKET]
+        flags = len(chunk) | (SHOW if first + len(chunk) == len(colours) else 0)
+        payload = bytes([HOST_CMD_ID, HOST_CMD_LED_FRAME, number & 0xFF, first, flags]) + b"".join(bytes(c) for c in chunk)
+        device.write(bytes([0x00]) + payload + bytes(PACKET - len(payload)))
+
+
+def rainbow(t, count):
+    return [tuple(int(255 * v) for v in colorsys.hsv_to_rgb((t / 4.0 + i / count) % 1.0, 1.0, 1.0)) for i in range(count)]
+
+
+def print_stats(device):
+    packets, frames, dropped, rejected = struct.unpack_from("<IIII", command(device, HOST_CMD_LED_STATS), 4)
+    print("led stream: %d packets, %d frames shown, %d dropped, %d rejected" % (packets, frames, dropped, rejected))
+
+
+def led_count():
+    with open(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "keyboard.json")) as f:
+        return json.load(f)["rgblight"]["led_count"]
+
+
+def main():
+    vid, pid = default_ids()
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--fps", type=float, default=100)
+    parser.add_argument("--seconds", type=float, default=10, help="0 streams until Ctrl-C")
+    parser.add_argument("--colour", help="RRGGBB for every LED instead of the rainbow")
+    parser.add_argument("--leds", type=int, default=led_count())
+    parser.add_argument("--stats", action="store_true", help="print the stream counters and exit")
+    parser.add_argument("--vid", type=lambda s: int(s, 0), default=vid)
+    parser.add_argument("--pid", type=lambda s: int(s, 0), default=pid)
+    args = parser.parse_args()
+
+    device = open_device(args.vid, args.pid)
+    if args.stats:
+        print_stats(device)
+        return
+
+    solid = [tuple(bytes.fromhex(args.colour))] * args.leds if args.colour else None
+    start = time.monotonic()
+    number = 0
+    try:
+        while not args.seconds or time.monotonic() - start < args.seconds:
+            due = start + number / args.fps
+            time.sleep(max(0.0, due - time.monotonic()))
+            send_frame(device, number, solid or rainbow(due - start, args.leds))
+            number += 1
+    except KeyboardInterrupt:
+        pass
+    elapsed = time.monotonic() - start
+    print("sent %d frames in %.1f s, %.1f fps" % (number, elapsed, number / elapsed))
+    print_stats(device)
+
+
+if __name__ == "__main__":
+    main()
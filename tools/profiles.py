@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+"""Pack keymap profiles into the flash image read by profile.c, and list or
+switch them on the keyboard.
+
+A profile is a keymap.json-style file with a name:
+    {"name": "editing", "layout": "LAYOUT_6x4", "layers": [[25 keycodes], ...]}
+Keycodes are QMK names (KC_P7, LCTL(KC_C), MO(4), PF_NEXT, ...), the custom
+keycodes of --keymap, or numbers.
+
+    tools/profiles.py pack profiles/*.json -o profiles.uf2    # drag onto RPI-RP2
+    tools/profiles.py pack profiles/*.json -o profiles.bin    # raw image
+    tools/profiles.py list                                    # on the keyboard
+    tools/profiles.py select 2
+
+The image goes to PROFILE_FLASH_OFFSET (profile.h), which --offset must
+match. Profile 0 is always the firmware's own keymap. Talking to the
+keyboard needs the hidapi module (pip install hid).
+"""
+
+import argparse
+import json
+import os
+import re
+import struct
+import sys
+import zlib
+
+from trace_decode import HOST_CMD_ID, PACKET, default_ids, open_device
+
+HOST_CMD_PROFILE = 0x09
+PROFILE_MAGIC = 0x4650524B
+PROFILE_VERSION = 1
+PROFILE_NAME_LEN = 16
+PROFILE_MAX = 16
+PROFILE_FLASH_OFFSET = 0x100000
+
+XIP_BASE = 0x10000000
+UF2_FAMILY_RP2040 = 0xE48BFF56
+UF2_PAYLOAD = 256
+
+ROOT = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..")
+
+# Values of QMK's keycodes.h.
+BASIC = {"KC_NO": 0x00, "XXXXXXX": 0x00, "KC_TRNS": 0x01, "KC_TRANSPARENT": 0x01, "_______": 0x01}
+BASIC.update({"KC_" + chr(ord("A") + i): 0x04 + i for i in range(26)})
+BASIC.update({"KC_%d" % ((i + 1) % 10): 0x1E + i for i in range(10)})
+BASIC.update({"KC_F%d" % (i + 1): 0x3A + i for i in range(12)})
+BASIC.update({"KC_F%d" % (i + 13): 0x68 + i for i in range(12)})
+BASIC.update({"KC_P%d" % ((i + 1) % 10): 0x59 + i for i in range(10)})
+for value, names in {
+    0x28: "ENT ENTER", 0x29: "ESC ESCAPE", 0x2A: "BSPC BACKSPACE", 0x2B: "TAB", 0x2C: "SPC SPACE",
+    0x2D: "MINS MINUS", 0x2E: "EQL EQUAL", 0x2F: "LBRC", 0x30: "RBRC", 0x31: "BSLS", 0x32: "NUHS",
+    0x33: "SCLN", 0x34: "QUOT", 0x35: "GRV", 0x36: "COMM COMMA", 0x37: "DOT", 0x38: "SLSH", 0x39: "CAPS",
+    0x46: "PSCR", 0x47: "SCRL", 0x48: "PAUS", 0x49: "INS INSERT", 0x4A: "HOME", 0x4B: "PGUP",
+    0x4C: "DEL DELETE", 0x4D: "END", 0x4E: "PGDN", 0x4F: "RGHT RIGHT", 0x50: "LEFT", 0x51: "DOWN",
+    0x52: "UP", 0x53: "NUM NUM_LOCK", 0x54: "PSLS", 0x55: "PAST", 0x56: "PMNS", 0x57: "PPLS", 0x58: "PENT",
+    0x63: "PDOT", 0x64: "NUBS", 0x65: "APP", 0x67: "PEQL",
+    0xA8: "MUTE", 0xA9: "VOLU", 0xAA: "VOLD", 0xAB: "MNXT", 0xAC: "MPRV", 0xAD: "MSTP", 0xAE: "MPLY",
+    0xCD: "MS_U", 0xCE: "MS_D", 0xCF: "MS_L", 0xD0: "MS_R", 0xD1: "BTN1", 0xD2: "BTN2", 0xD3: "BTN3",
+    0xD9: "WH_U", 0xDA: "WH_D", 0xDB: "WH_L", 0xDC: "WH_R",
+    0xE0: "LCTL", 0xE1: "LSFT", 0xE2: "LALT", 0xE3: "LGUI", 0xE4: "RCTL", 0xE5: "RSFT", 0xE6: "RALT", 0xE7: "RGUI",
+}.items():
+    BASIC.update({"KC_" + name: value for name in names.split()})
+# QMK's current mouse key names.
+BASIC.update({"MS_" + name: 0xCD + i for i, name in enumerate("UP DOWN LEFT RGHT BTN1 BTN2 BTN3 BTN4 BTN5 BTN6 BTN7 BTN8 WHLU WHLD WHLL WHLR".split())})
+
+MODS = {"LCTL": 0x0100, "C": 0x0100, "LSFT": 0x0200, "S": 0x0200, "LALT": 0x0400, "A": 0x0400,
+        "LGUI": 0x0800, "G": 0x0800, "RCTL": 0x1100, "RSFT": 0x1200, "RALT": 0x1400, "RGUI": 0x1800}
+LAYERS = {"TO": 0x5200, "MO": 0x5220, "DF": 0x5240, "TG": 0x5260}
+
+QK_KB_0 = 0x7E00
+SAFE_RANGE = 0x7E40
+KEYBOARD = {"PF_NEXT": QK_KB_0}
+
+
+def custom_keycodes(path):
+    with open(path) as f:
+        source = f.read()
+    match = re.search(r"enum\s+custom_keycodes\s*{(.*?)}", source, re.S)
+    if not match:
+        return {}
+    names = [n.split("=")[0].strip() for n in match.group(1).split(",") if n.strip()]
+    return {name: SAFE_RANGE + i for i, name in enumerate(names)}
+
+
+def keycode(text, custom):
+    text = text.strip()
+    call = re.fullmatch(r"(\w+)\((.*)\)", text)
+    if call:
+        func, arg = call.groups()
+        if func in MODS:
+            return MODS[func] | keycode(arg, custom)
+        if func in LAYERS:
+            return LAYERS[func] | (int(arg, 0) & 0x1F)
+        raise ValueError("unknown function %s" % func)
+    for table in (BASIC, KEYBOARD, custom):
+        if text in table:
+            return table[text]
+    try:
+        return int(text, 0)
+    except ValueError:
+        raise ValueError("unknown keycode %s" % text) from None
+
+
+def load_keyboard():
+    with open(os.path.join(ROOT, "keyboard.json")) as f:
+        info = json.load(f)
+    size = info["matrix_size"]
+    return size["rows"], size["cols"], {name: [key["matrix"] for key in layout["layout"]] for name, layout in info["layouts"].items()}
+
+
+def pack_profile(path, rows, cols, layouts, layer_count, custom):
+    with open(path) as f:
+        profile = json.load(f)
+    name = profile["name"].encode()
+    if len(name) > PROFILE_NAME_LEN:
+        sys.exit("%s: name longer than %d bytes" % (path, PROFILE_NAME_LEN))
+    positions = layouts[profile["layout"]]
+    layers = profile["layers"]
+    if len(layers) != layer_count:
+        sys.exit("%s: %d layers, the other profiles have %d" % (path, len(layers), layer_count))
+
+    data = name + bytes(PROFILE_NAME_LEN - len(name))
+    for number, layer in enumerate(layers):
+        if len(layer) != len(positions):
+            sys.exit("%s: layer %d has %d keys, %s has %d" % (path, number, len(layer), profile["layout"], len(positions)))
+        matrix = [[0] * cols for _ in range(rows)]
+        for (row, col), text in zip(positions, layer):
+            try:
+                matrix[row][col] = keycode(text, custom)
+            except ValueError as error:
+                sys.exit("%s: layer %d: %s" % (path, number, error))
+        data += b"".join(struct.pack("<%dH" % cols, *row) for row in matrix)
+    return data
+
+
+def uf2(image, address):
+    blocks = [image[i : i + UF2_PAYLOAD] for i in range(0, len(image), UF2_PAYLOAD)]
+    out = b""
+    for number, block in enumerate(blocks):
+        header = struct.pack("<IIIIIIII", 0x0A324655, 0x9E5D5157, 0x2000, address + number * UF2_PAYLOAD, UF2_PAYLOAD, number, len(blocks), UF2_FAMILY_RP2040)
+        out += header + block.ljust(476, b"\0") + struct.pack("<I", 0x0AB16F30)
+    return out
+
+
+def pack(args):
+    if not args.profiles or len(args.profiles) >= PROFILE_MAX:
+        sys.exit("between 1 and %d profiles" % (PROFILE_MAX - 1))
+    rows, cols, layouts = load_keyboard()
+    custom = custom_keycodes(args.keymap)
+    with open(args.profiles[0]) as f:
+        layer_count = len(json.load(f)["layers"])
+
+    body = b"".join(pack_profile(path, rows, cols, layouts, layer_count, custom) for path in args.profiles)
+    header = struct.pack("<IHBBBBHI", PROFILE_MAGIC, PROFILE_VERSION, len(args.profiles), layer_count, rows, cols, 0, zlib.crc32(body))
+    image = header + body
+    with open(args.output, "wb") as f:
+        f.write(uf2(image, XIP_BASE + args.offset) if args.output.endswith(".uf2") else image)
+    print("%s: %d profiles, %d layers, %d bytes at flash offset 0x%x" % (args.output, len(args.profiles), layer_count, len(image), args.offset))
+
+
+def profile_command(device, select, named=0xFF):
+    device.write(bytes([0x00, HOST_CMD_ID, HOST_CMD_PROFILE, select, named]) + bytes(PACKET - 4))
+    reply = bytes(device.read(PACKET, 1000))
+    if len(reply) < 4 + PROFILE_NAME_LEN or reply[0] != HOST_CMD_ID or reply[1] != HOST_CMD_PROFILE:
+        sys.exit("no such profile, or the firmware is built without PROFILES_ENABLE")
+    return reply[2], reply[3], reply[4 : 4 + PROFILE_NAME_LEN].split(b"\0")[0].decode(errors="replace")
+
+
+def device_main(args):
+    device = open_device(args.vid, args.pid)
+    if args.command == "select":
+        current, _, name = profile_command(device, args.index)
+        print("profile %d %s" % (current, name))
+        return
+    current, count, _ = profile_command(device, 0xFF)
+    for index in range(count):
+        _, _, name = profile_command(device, 0xFF, index)
+        print("%s %d %s" % ("*" if index == current else " ", index, name))
+
+
+def main():
+    vid, pid = default_ids()
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    commands = parser.add_subparsers(dest="command", required=True)
+    packer = commands.add_parser("pack", help="build the flash image")
+    packer.add_argument("profiles", nargs="+")
+    packer.add_argument("-o", "--output", default="profiles.uf2", help=".uf2 for the bootloader, anything else for the raw image")
+    packer.add_argument("--offset", type=lambda s: int(s, 0), default=PROFILE_FLASH_OFFSET)
+    packer.add_argument("--keymap", default=os.path.join(ROOT, "keymaps", "default", "keymap.c"), help="keymap.c whose custom keycodes the profiles use")
+    commands.add_parser("list", help="list the profiles on the keyboard")
+    selector = commands.add_parser("select", help="switch the keyboard to a profile")
+    selector.add_argument("index", type=int)
+    for sub in commands.choices.values():
+        sub.add_argument("--vid", type=lambda s: int(s, 0), default=vid)
+        sub.add_argument("--pid", type=lambda s: int(s, 0), default=pid)
+    args = parser.parse_args()
+
+    if args.command == "pack":
+        pack(args)
+    else:
+        device_main(args)
+
+
+if __name__ == "__main__":
+    main()
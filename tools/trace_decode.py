@@ -0,0 +1,297 @@
+#!/usr/bin/env python3
+"""Read the latency trace (trace.h) from the keyboard and print per-stage
+latency histograms.
+
+Build with LATENCY_TRACE_ENABLE=yes, then
+    tools/trace_decode.py --seconds 30          # type while it records
+    tools/trace_decode.py --input dump.txt      # decode a saved dump
+    tools/trace_decode.py --store-stats         # flash writes of the RGB store
+    tools/trace_decode.py --loop-stats 10       # scan period and XIP cache
+    tools/trace_decode.py --boot                # boot phase timeline
+    tools/trace_decode.py --power               # idle states, sleep, wake
+    tools/trace_decode.py --report-stats        # reports saved by coalescing
+    make -C sim trace                           # simulator round trip
+    make -C sim boot                            # simulated fast boot
+    make -C sim power                           # simulated idle and suspend
+
+Reading the device needs the hidapi module (pip install hid). Every reply
+packet is one hex line in --dump/--input files.
+"""
+
+import argparse
+import json
+import os
+import struct
+import sys
+import time
+
+HOST_CMD_ID = 0xF8
+HOST_CMD_TRACE_READ = 0x01
+HOST_CMD_RGB_STORE_STATS = 0x02
+HOST_CMD_LOOP_STATS = 0x03
+HOST_CMD_BOOT_TIMELINE = 0x04
+HOST_CMD_POWER_STATS = 0x05
+HOST_CMD_REPORT_STATS = 0x06
+PACKET = 32
+RAW_USAGE_PAGE = 0xFF60
+RAW_USAGE = 0x61
+
+EVENTS = {
+    1: "matrix",
+    2: "debounce",
+    3: "record_enter",
+    4: "record_exit",
+    5: "layer",
+    6: "rgb_request",
+    7: "rgb_apply",
+    8: "report_keyboard",
+    9: "report_nkro",
+    10: "report_mouse",
+    11: "flash_write",
+    12: "rgb_frame",
+    13: "macro_step",
+}
+
+# enum boot_phase in boot_time.h
+BOOT_PHASES = ("keyboard_init", "post_init", "main_loop", "usb_configured", "user_init", "first_key")
+
+# enum power_state in power.h
+POWER_STATES = ("active", "idle", "sleep", "suspend")
+
+# Mouse reports come from the encoder, not the matrix.
+KEY_REPORTS = ("report_keyboard", "report_nkro")
+
+# (name, start events, end events, which pending start a span is measured
+# from when several arrive before the end: coalescing stages use the first)
+SPANS = [
+    ("scan->report", ("matrix",), KEY_REPORTS, "last"),
+    ("matrix->debounce", ("matrix",), ("debounce",), "last"),
+    ("debounce->record", ("debounce",), ("record_enter",), "last"),
+    ("process_record", ("record_enter",), ("record_exit",), "last"),
+    ("record->report", ("record_exit",), KEY_REPORTS, "last"),
+    ("layer->rgb_request", ("layer",), ("rgb_request",), "last"),
+    ("rgb_request->apply", ("rgb_request",), ("rgb_apply",), "first"),
+]
+
+
+def default_ids():
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "keyboard.json")
+    with open(path) as f:
+        usb = json.load(f)["usb"]
+    return int(usb["vid"], 16), int(usb["pid"], 16)
+
+
+def open_device(vid, pid):
+    import hid
+
+    for info in hid.enumerate(vid, pid):
+        if info["usage_page"] == RAW_USAGE_PAGE and info["usage"] == RAW_USAGE:
+            device = hid.Device(path=info["path"])
+            return device
+    sys.exit("no raw HID interface found for %04x:%04x" % (vid, pid))
+
+
+def command(device, cmd):
+    device.write(bytes([0x00, HOST_CMD_ID, cmd]) + bytes(PACKET - 2))
+    reply = device.read(PACKET, 1000)
+    if not reply or reply[0] != HOST_CMD_ID or reply[1] != cmd:
+        sys.exit("unexpected reply, is the firmware built with this command?")
+    return bytes(reply)
+
+
+def store_stats(vid, pid):
+    writes, total, peak, last = struct.unpack_from("<IIII", command(open_device(vid, pid), HOST_CMD_RGB_STORE_STATS), 4)
+    print("rgb store: %d flash writes, stall avg %d us, max %d us, last %d us" % (writes, total // writes if writes else 0, peak, last))
+
+
+def report_stats(vid, pid):
+    reports_in, reports_out, kept_apart = struct.unpack_from("<III", command(open_device(vid, pid), HOST_CMD_REPORT_STATS), 4)
+    print("reports: %d asked for, %d sent (%d kept apart to keep a change), %d saved" % (reports_in, reports_out, kept_apart, reports_in - reports_out))
+
+
+def print_loop_stats(reply):
+    hits, accesses, loops, low, high, total = struct.unpack_from("<IIIIII", reply, 4)
+    print("main loop: %d loops, period min %d us, avg %.1f us, max %d us, jitter %d us" % (loops, low, total / loops if loops else 0, high, high - low))
+    print("xip cache: %d accesses, %d misses, hit rate %.2f%%" % (accesses, accesses - hits, 100.0 * hits / accesses if accesses else 100.0))
+
+
+def loop_stats(vid, pid, seconds):
+    device = open_device(vid, pid)
+    command(device, HOST_CMD_LOOP_STATS)
+    time.sleep(seconds)
+    print_loop_stats(command(device, HOST_CMD_LOOP_STATS))
+
+
+def print_boot_timeline(reply):
+    count, reached = reply[2], reply[3]
+    stamps = struct.unpack_from("<%dI" % count, reply, 4)
+    print("%-16s %10s %10s" % ("phase", "at ms", "+ms"))
+    previous = 0
+    for i in range(count):
+        name = BOOT_PHASES[i] if i < len(BOOT_PHASES) else "phase%d" % i
+        if not reached & (1 << i):
+            print("%-16s %10s" % (name, "-"))
+            continue
+        print("%-16s %10.3f %10.3f" % (name, stamps[i] / 1000.0, (stamps[i] - previous) / 1000.0))
+        previous = stamps[i]
+    # A key pressed from then on is reported in the same scan.
+    ready = [stamps[i] for i in (2, 3) if reached & (1 << i)]
+    if len(ready) == 2:
+        print("ready for the first report at %.3f ms" % (max(ready) / 1000.0))
+
+
+def print_power_stats(replies, run_ma, sleep_ma):
+    print("%-8s %10s %8s %8s %8s %12s %12s %8s" % ("state", "s", "asleep%", "sleeps", "edges", "wake_us_last", "wake_us_max", "est_mA"))
+    for reply in replies:
+        state = reply[2]
+        ms, asleep, sleeps, edges, last, peak = struct.unpack_from("<IIIIII", reply, 4)
+        name = POWER_STATES[state] if state < len(POWER_STATES) else "state%d" % state
+        duty = asleep / ms if ms else 0.0
+        # Time-weighted: awake at run_ma, asleep at sleep_ma. LEDs not included.
+        print("%-8s %10.1f %8.1f %8d %8d %12d %12d %8.2f" % (name, ms / 1000.0, 100.0 * duty, sleeps, edges, last, peak, run_ma * (1 - duty) + sleep_ma * duty))
+
+
+def power_stats(vid, pid, run_ma, sleep_ma):
+    device = open_device(vid, pid)
+    replies = []
+    for state in range(len(POWER_STATES)):
+        device.write(bytes([0x00, HOST_CMD_ID, HOST_CMD_POWER_STATS, state]) + bytes(PACKET - 3))
+        reply = device.read(PACKET, 1000)
+        if not reply or reply[0] != HOST_CMD_ID or reply[1] != HOST_CMD_POWER_STATS:
+            sys.exit("unexpected reply, is the firmware built with POWER_SAVE_ENABLE?")
+        replies.append(bytes(reply))
+    print_power_stats(replies, run_ma, sleep_ma)
+
+
+def read_device(vid, pid, seconds, interval):
+    device = open_device(vid, pid)
+    packets = []
+    end = time.monotonic() + seconds
+    while time.monotonic() < end:
+        while True:
+            reply = command(device, HOST_CMD_TRACE_READ)
+            packets.append(reply)
+            if reply[2] == 0:
+                break
+        time.sleep(interval)
+    return packets
+
+
+def read_file(path):
+    stream = sys.stdin if path == "-" else open(path)
+    return [bytes.fromhex(line.strip()) for line in stream if line.strip()]
+
+
+def decode(packets):
+    entries = []
+    lost = 0
+    for packet in packets:
+        if packet[0] != HOST_CMD_ID or packet[1] != HOST_CMD_TRACE_READ:
+            continue
+        count, dropped = packet[2], packet[3]
+        lost += dropped
+        for i in range(count):
+            stamp, tag = struct.unpack_from("<II", packet, 4 + i * 8)
+            entries.append((stamp, EVENTS.get(tag & 0xFF, "event%d" % (tag & 0xFF)), tag >> 8))
+    return entries, lost
+
+
+def measure(entries, starts, ends, keep):
+    samples = []
+    pending = None
+    for stamp, event, _ in entries:
+        if event in starts and (pending is None or keep == "last"):
+            pending = stamp
+        elif event in ends and pending is not None:
+            samples.append((stamp - pending) & 0xFFFFFFFF)
+            pending = None
+    return sorted(samples)
+
+
+def percentile(samples, p):
+    return samples[min(len(samples) - 1, int(len(samples) * p / 100))]
+
+
+def histogram(samples):
+    buckets = {}
+    for us in samples:
+        bucket = 0 if us == 0 else 1 << (us.bit_length() - 1)
+        buckets[bucket] = buckets.get(bucket, 0) + 1
+    peak = max(buckets.values())
+    for bucket in sorted(buckets):
+        label = "0" if bucket == 0 else "%d-%d" % (bucket, bucket * 2 - 1)
+        print("    %12s us %6d %s" % (label, buckets[bucket], "#" * max(1, buckets[bucket] * 40 // peak)))
+
+
+def main():
+    vid, pid = default_ids()
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--input", help="decode a hex dump instead of reading the device ('-' for stdin)")
+    parser.add_argument("--dump", help="also save the raw packets to this file")
+    parser.add_argument("--seconds", type=float, default=10, help="how long to record from the device")
+    parser.add_argument("--interval", type=float, default=0.005, help="poll interval; the ring holds 256 entries")
+    parser.add_argument("--vid", type=lambda s: int(s, 0), default=vid)
+    parser.add_argument("--pid", type=lambda s: int(s, 0), default=pid)
+    parser.add_argument("--histogram", action="store_true", help="print a log2 histogram per stage")
+    parser.add_argument("--store-stats", action="store_true", help="print the RGB store flash write counters and exit")
+    parser.add_argument("--boot", action="store_true", help="print the boot phase timeline and exit")
+    parser.add_argument("--report-stats", action="store_true", help="print the report coalescing counters and exit")
+    parser.add_argument("--power", action="store_true", help="print time, sleep and wake latency per power state and exit")
+    parser.add_argument("--run-ma", type=float, default=24.0, help="current while awake for --power; measure your board")
+    parser.add_argument("--sleep-ma", type=float, default=10.0, help="current while asleep (WFI) for --power")
+    parser.add_argument("--loop-stats", type=float, metavar="SECONDS", help="count main loop period and XIP cache misses for SECONDS and exit")
+    args = parser.parse_args()
+
+    if args.boot:
+        packets = read_file(args.input) if args.input else [command(open_device(args.vid, args.pid), HOST_CMD_BOOT_TIMELINE)]
+        for packet in packets:
+            if packet[0] == HOST_CMD_ID and packet[1] == HOST_CMD_BOOT_TIMELINE:
+                print_boot_timeline(packet)
+        return
+    if args.power:
+        if args.input:
+            print_power_stats([p for p in read_file(args.input) if p[0] == HOST_CMD_ID and p[1] == HOST_CMD_POWER_STATS], args.run_ma, args.sleep_ma)
+        else:
+            power_stats(args.vid, args.pid, args.run_ma, args.sleep_ma)
+        return
+    if args.store_stats:
+        store_stats(args.vid, args.pid)
+        return
+    if args.report_stats:
+        report_stats(args.vid, args.pid)
+        return
+    if args.loop_stats is not None:
+        loop_stats(args.vid, args.pid, args.loop_stats)
+        return
+
+    packets = read_file(args.input) if args.input else read_device(args.vid, args.pid, args.seconds, args.interval)
+    if args.dump:
+        with open(args.dump, "w") as f:
+            f.writelines(p.hex() + "\n" for p in packets)
+
+    for packet in packets:
+        if packet[0] == HOST_CMD_ID and packet[1] == HOST_CMD_LOOP_STATS:
+            print_loop_stats(packet)
+
+    entries, lost = decode(packets)
+    print("%d entries, %d lost to ring overruns" % (len(entries), lost))
+    print("%-20s %7s %9s %9s %9s" % ("stage", "count", "p50 us", "p99 us", "max us"))
+    for name, starts, ends, keep in SPANS:
+        samples = measure(entries, starts, ends, keep)
+        if not samples:
+            continue
+        print("%-20s %7d %9d %9d %9d" % (name, len(samples), percentile(samples, 50), percentile(samples, 99), samples[-1]))
+        if args.histogram:
+            histogram(samples)
+
+    # Flash writes and effect frames carry their own duration.
+    for event, name in (("flash_write", "flash_write stall"), ("rgb_frame", "rgb_frame render")):
+        stalls = sorted(arg for _, e, arg in entries if e == event)
+        if stalls:
+            print("%-20s %7d %9d %9d %9d" % (name, len(stalls), percentile(stalls, 50), percentile(stalls, 99), stalls[-1]))
+            if args.histogram:
+                histogram(stalls)
+
+
+if __name__ == "__main__":
+    main()
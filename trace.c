@@ -0,0 +1,104 @@
+// Storage and read-out for the latency trace (trace.h), plus the hook on the
+// USB host driver that timestamps every report as it is handed over.
+//
+// The hook copies the active host driver and replaces the report callbacks
+// with wrappers. The driver is only set after keyboard_post_init, so it is
+// installed lazily from housekeeping.
+//
+// trace_task() also times the main loop, and the XIP cache's own hit and
+// access counters show how often code had to come from flash meanwhile.
+
+#include <string.h>
+#include "quantum.h"
+#include "trace.h"
+#include "hot_path.h"
+#include "hardware/structs/xip_ctrl.h"
+
+#ifdef LATENCY_TRACE_ENABLE
+
+trace_entry_t     trace_ring[TRACE_RING_SIZE];
+volatile uint32_t trace_head = 0;
+
+static uint32_t      trace_tail = 0;
+static host_driver_t traced_driver;
+static host_driver_t *inner_driver = NULL;
+
+static trace_loop_stats_t loop_stats = {.loop_us_min = UINT32_MAX};
+static uint32_t           loop_at    = 0;
+
+static void HOT_PATH(traced_send_keyboard)(report_keyboard_t *report) {
+    TRACE(TRACE_REPORT_KEYBOARD, report->mods);
+    inner_driver->send_keyboard(report);
+}
+
+static void HOT_PATH(traced_send_nkro)(report_nkro_t *report) {
+    TRACE(TRACE_REPORT_NKRO, report->mods);
+    inner_driver->send_nkro(report);
+}
+
+static void HOT_PATH(traced_send_mouse)(report_mouse_t *report) {
+    TRACE(TRACE_REPORT_MOUSE, report->buttons);
+    inner_driver->send_mouse(report);
+}
+
+static void time_loop(void) {
+    uint32_t now = TRACE_NOW();
+
+    if (loop_at != 0) {
+        uint32_t period = now - loop_at;
+        loop_stats.loops++;
+        loop_stats.loop_us_total += period;
+        loop_stats.loop_us_min = MIN(loop_stats.loop_us_min, period);
+        loop_stats.loop_us_max = MAX(loop_stats.loop_us_max, period);
+    }
+    loop_at = now;
+}
+
+void trace_loop_stats(trace_loop_stats_t *stats) {
+    *stats              = loop_stats;
+    stats->xip_hits     = xip_ctrl_hw->ctr_hit;
+    stats->xip_accesses = xip_ctrl_hw->ctr_acc;
+    if (stats->loops == 0) {
+        stats->loop_us_min = 0;
+    }
+
+    // Writing either counter clears it.
+    xip_ctrl_hw->ctr_hit = 0;
+    xip_ctrl_hw->ctr_acc = 0;
+    loop_stats           = (trace_loop_stats_t){.loop_us_min = UINT32_MAX};
+    loop_at              = 0;
+}
+
+void trace_task(void) {
+    time_loop();
+
+    // Once only: report_coalesce.c wraps the driver in turn.
+    host_driver_t *driver = host_get_driver();
+    if (driver == NULL || inner_driver != NULL) {
+        return;
+    }
+
+    inner_driver                = driver;
+    traced_driver               = *driver;
+    traced_driver.send_keyboard = traced_send_keyboard;
+    traced_driver.send_nkro     = traced_send_nkro;
+    traced_driver.send_mouse    = traced_send_mouse;
+    host_set_driver(&traced_driver);
+}
+
+uint8_t trace_read(uint8_t *buf, uint8_t length, uint8_t *lost) {
+    uint32_t head    = trace_head;
+    uint32_t overrun = head - trace_tail > TRACE_RING_SIZE ? head - trace_tail - TRACE_RING_SIZE : 0;
+    uint8_t  count   = 0;
+
+    *lost = MIN(overrun, UINT8_MAX);
+    trace_tail += overrun;
+    while (trace_tail != head && (count + 1) * sizeof(trace_entry_t) <= length) {
+        memcpy(buf + count * sizeof(trace_entry_t), &trace_ring[trace_tail & (TRACE_RING_SIZE - 1)], sizeof(trace_entry_t));
+        trace_tail++;
+        count++;
+    }
+    return count;
+}
+
+#endif
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <stdint.h>
+
+// Latency trace: a RAM ring of (timestamp, event, argument) records along
+// the scan-to-USB path, read out over raw HID by tools/trace_decode.py.
+// TRACE() compiles to nothing unless LATENCY_TRACE_ENABLE is set.
+
+enum trace_event {
+    TRACE_MATRIX = 1,       // raw matrix changed; arg: row << 8 | cols
+    TRACE_DEBOUNCE,         // debounced row changed; arg: row << 8 | cols
+    TRACE_RECORD_ENTER,     // process_record_user() entry; arg: keycode
+    TRACE_RECORD_EXIT,      // process_record_user() exit; arg: keycode
+    TRACE_LAYER,            // layer_state_set_user(); arg: new state
+    TRACE_RGB_REQUEST,      // apply_rgb_state() -> rgb_state_request(); arg: hue
+    TRACE_RGB_APPLY,        // rgb_state_task() pushed a frame; arg: hue
+    TRACE_REPORT_KEYBOARD,  // keyboard report handed to USB; arg: mods
+    TRACE_REPORT_NKRO,      // NKRO report handed to USB; arg: mods
+    TRACE_REPORT_MOUSE,     // mouse report handed to USB; arg: buttons
+    TRACE_FLASH_WRITE,      // settings written to flash; arg: stall in us
+    TRACE_RGB_FRAME,        // effect frame rendered; arg: render time in us
+    TRACE_MACRO_STEP,       // macro step sent; arg: keycode, bit 15 = release
+};
+
+#ifndef TRACE_RING_SIZE
+#    define TRACE_RING_SIZE 256
+#endif
+
+// 1 us free-running timer, wraps every ~71 minutes. Also usable without the
+// trace for one-off measurements.
+#ifndef TRACE_NOW
+#    include "hardware/structs/timer.h"
+#    define TRACE_NOW() (timer_hw->timerawl)
+#endif
+
+#ifdef LATENCY_TRACE_ENABLE
+
+_Static_assert((TRACE_RING_SIZE & (TRACE_RING_SIZE - 1)) == 0, "TRACE_RING_SIZE must be a power of two");
+
+typedef struct {
+    uint32_t time;
+    uint32_t tag; // event | arg << 8
+} trace_entry_t;
+
+extern trace_entry_t     trace_ring[TRACE_RING_SIZE];
+extern volatile uint32_t trace_head;
+
+// Only ever called from the main loop on core 0, so a plain index bump is
+// enough; the reader notices overruns from the distance to trace_head.
+static inline void trace_record(uint8_t event, uint32_t arg) {
+    trace_entry_t *entry = &trace_ring[trace_head++ & (TRACE_RING_SIZE - 1)];
+    entry->time          = TRACE_NOW();
+    entry->tag           = event | arg << 8;
+}
+
+#    define TRACE(event, arg) trace_record((event), (arg))
+
+// Installs the report hooks once the USB host driver is up.
+void trace_task(void);
+
+// Fills buf with as many 8-byte entries as fit and returns how many. *lost
+// counts entries overwritten before they could be read (saturating).
+uint8_t trace_read(uint8_t *buf, uint8_t length, uint8_t *lost);
+
+// XIP cache counters and main loop (= scan) period since the last call.
+// Misses are accesses minus hits.
+typedef struct {
+    uint32_t xip_hits;
+    uint32_t xip_accesses;
+    uint32_t loops;
+    uint32_t loop_us_min;
+    uint32_t loop_us_max;
+    uint32_t loop_us_total;
+} trace_loop_stats_t;
+
+// Copies the counters out and starts a new interval.
+void trace_loop_stats(trace_loop_stats_t *stats);
+
+#else
+#    define TRACE(event, arg) ((void)0)
+#endif
@@ -0,0 +1,24 @@
+#pragma once
+
+// WS2812 PIO program from the Pico SDK examples, assembled by hand (the QMK
+// build has no pioasm step). One bit takes T1 + T2 + T3 = 10 cycles, so the
+// state machine runs at 10 x 800 kHz. Data is shifted out MSB first from the
+// top 24 bits of each FIFO word; the line idles low between frames.
+//
+//  0  bitloop: out x, 1       side 0 [T3 - 1]
+//  1           jmp !x, 3      side 1 [T1 - 1]
+//  2           jmp bitloop    side 1 [T2 - 1]
+//  3  do_zero: nop            side 0 [T2 - 1]   ; wrap
+//
+// Uses one mandatory side-set pin. Jump targets are relative to offset 0;
+// pio_add_program() relocates them.
+
+#include <stdint.h>
+
+#define ws2812_wrap_target 0
+#define ws2812_wrap 3
+#define ws2812_cycles_per_bit 10
+
+static const uint16_t ws2812_program_instructions[] = {
+    0x6221, 0x1123, 0x1400, 0xa442,
+};
@@ -0,0 +1,133 @@
+// Double-buffered WS2812 output (WS2812_DRIVER = custom) for the RP2040.
+//
+// ws2812_set_color() writes the final GRB word straight into the back
+// buffer, going through a 256-byte LUT in SRAM that folds gamma 2.2 and the
+// RGBLIGHT_LIMIT_VAL cap into one load per channel. ws2812_flush() hands
+// the buffer to DMA, which streams it into the PIO FIFO, and returns. If the
+// previous frame is still on the wire (LED_COUNT x 30 us plus the latch
+// time) the new one is left pending and ws2812_dma_task() starts it from
+// housekeeping; a newer flush just replaces it. Nothing ever waits for the
+// strip, so its length does not show up in the scan time.
+
+#include "quantum.h"
+#include "ws2812.h"
+#include "ws2812_dma.h"
+#include "ws2812.pio.h"
+#include "hardware/pio.h"
+#include "hardware/clocks.h"
+#include "hardware/structs/timer.h"
+
+#ifndef WS2812_DMA_PIO
+#    define WS2812_DMA_PIO pio0
+#endif
+
+#ifndef RGBLIGHT_LIMIT_VAL
+#    define RGBLIGHT_LIMIT_VAL 255
+#endif
+
+#define LED_US 30
+#define LATCH_US 300
+
+static const uint8_t gamma22[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 6, 6, 6,
+    6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10, 11, 11, 11, 12,
+    12, 13, 13, 13, 14, 14, 15, 15, 16, 16, 17, 17, 18, 18, 19, 19,
+    20, 20, 21, 22, 22, 23, 23, 24, 25, 25, 26, 26, 27, 28, 28, 29,
+    30, 30, 31, 32, 33, 33, 34, 35, 35, 36, 37, 38, 39, 39, 40, 41,
+    42, 43, 43, 44, 45, 46, 47, 48, 49, 49, 50, 51, 52, 53, 54, 55,
+    56, 57, 58, 59, 60, 61, 62, 63, 64, 65, 66, 67, 68, 69, 70, 71,
+    73, 74, 75, 76, 77, 78, 79, 81, 82, 83, 84, 85, 87, 88, 89, 90,
+    91, 93, 94, 95, 97, 98, 99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+static const pio_program_t ws2812_program = {
+    .instructions = ws2812_program_instructions,
+    .length       = ARRAY_SIZE(ws2812_program_instructions),
+    .origin       = -1,
+};
+
+static uint8_t                 gamma_lut[256];
+static uint32_t                frames[2][WS2812_LED_COUNT];
+static uint8_t                 back    = 0;
+static bool                    pending = false;
+static uint32_t                busy_until;
+static PIO                     pio = WS2812_DMA_PIO;
+static int                     state_machine;
+static const rp_dma_channel_t *dma;
+
+void ws2812_init(void) {
+    // Rescaled so the cap itself still maps to full cap brightness.
+    for (uint16_t x = 0; x < 256; x++) {
+        gamma_lut[x] = x >= RGBLIGHT_LIMIT_VAL ? RGBLIGHT_LIMIT_VAL : gamma22[x * 255 / RGBLIGHT_LIMIT_VAL] * RGBLIGHT_LIMIT_VAL / 255;
+    }
+
+    state_machine   = pio_claim_unused_sm(pio, true);
+    uint32_t offset = pio_add_program(pio, &ws2812_program);
+
+    pio_gpio_init(pio, WS2812_DI_PIN);
+    pio_sm_set_consecutive_pindirs(pio, state_machine, WS2812_DI_PIN, 1, true);
+
+    pio_sm_config config = pio_get_default_sm_config();
+    sm_config_set_wrap(&config, offset + ws2812_wrap_target, offset + ws2812_wrap);
+    sm_config_set_sideset(&config, 1, false, false);
+    sm_config_set_sideset_pins(&config, WS2812_DI_PIN);
+    sm_config_set_out_shift(&config, false, true, 24);
+    sm_config_set_fifo_join(&config, PIO_FIFO_JOIN_TX);
+    sm_config_set_clkdiv(&config, (float)clock_get_hz(clk_sys) / (800000 * ws2812_cycles_per_bit));
+    pio_sm_init(pio, state_machine, offset, &config);
+    pio_sm_set_enabled(pio, state_machine, true);
+
+    dma        = dmaChannelAllocI(RP_DMA_CHANNEL_ID_ANY, 2, NULL, NULL);
+    busy_until = timer_hw->timerawl;
+}
+
+void ws2812_set_color(int index, uint8_t red, uint8_t green, uint8_t blue) {
+    frames[back][index] = (uint32_t)gamma_lut[green] << 24 | (uint32_t)gamma_lut[red] << 16 | (uint32_t)gamma_lut[blue] << 8;
+}
+
+void ws2812_set_color_all(uint8_t red, uint8_t green, uint8_t blue) {
+    for (int i = 0; i < WS2812_LED_COUNT; i++) {
+        ws2812_set_color(i, red, green, blue);
+    }
+}
+
+static bool strip_idle(void) {
+    return (int32_t)(timer_hw->timerawl - busy_until) >= 0;
+}
+
+// Streams the back buffer. The other buffer belongs to the frame before,
+// which is off the wire by now, so it becomes the new back buffer.
+static void start_frame(void) {
+    const uint32_t *front = frames[back];
+
+    back ^= 1;
+    pending    = false;
+    busy_until = timer_hw->timerawl + WS2812_LED_COUNT * LED_US + LATCH_US;
+
+    dmaChannelSetSourceX(dma, (uint32_t)front);
+    dmaChannelSetDestinationX(dma, (uint32_t)&pio->txf[state_machine]);
+    dmaChannelSetCounterX(dma, WS2812_LED_COUNT);
+    dmaChannelSetModeX(dma, DMA_CTRL_TRIG_INCR_READ | DMA_CTRL_TRIG_DATA_SIZE_WORD | DMA_CTRL_TRIG_TREQ_SEL(pio_get_dreq(pio, state_machine, true)));
+    dmaChannelEnableX(dma);
+}
+
+void ws2812_flush(void) {
+    if (strip_idle()) {
+        start_frame();
+    } else {
+        pending = true;
+    }
+}
+
+void ws2812_dma_task(void) {
+    if (pending && strip_idle()) {
+        start_frame();
+    }
+}
@@ -0,0 +1,5 @@
+#pragma once
+
+// Starts a frame that ws2812_flush() had to leave pending because the
+// previous one was still being clocked out. Call from housekeeping.
+void ws2812_dma_task(void);